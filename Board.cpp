@@ -17,14 +17,12 @@
 
 #include "gPreCalc.h"
 #include "log.h"
+#include "Material.h"
 #include "ref.h"
 #include "ui.h"
 #include "uiUtil.h"
 #include "Variant.h"
 
-using arctic::File;
-using arctic::Rank;
-
 // #define DEBUG_CONSISTENCY_CHECK
 
 static constexpr bool isPow2(int c)
@@ -56,6 +54,10 @@ public:
     void updatePPieces();
     void syncPieceVectors(const Board &other);
     uint64 calcZobrist() const;
+    uint64 calcMaterialKey() const;
+    uint64 calcPawnZobrist() const;
+    PhasedScoreT calcPositionalStrength(uint8 player) const;
+    void updateAccumulator(const UnMakeT &unmake);
 private:
     inline void updateCoord(cell_t coord, Piece piece);
     inline void addPieceZ(cell_t coord, Piece piece);
@@ -80,8 +82,12 @@ void PrivBoard::addPiece(cell_t coord, Piece piece)
 {
     pieceCoords[piece.ToIndex()].push_back(coord);
     pPiece[coord] = &pieceCoords[piece.ToIndex()].back();
-    totalStrength += piece.Worth();
     materialStrength[piece.Player()] += piece.Worth();
+    positionalStrength[piece.Player()] +=
+        gPreCalc.pst[piece.ToIndex()] [coord];
+    materialKey += gPreCalc.materialKey[piece.ToIndex()] [coord];
+    if (piece.IsPawn())
+        pawnZobrist ^= gPreCalc.zobrist.coord[piece.ToIndex()] [coord];
     updateCoord(coord, piece);
 }
 
@@ -98,7 +104,11 @@ void PrivBoard::capturePiece(cell_t coord, Piece piece)
     cell_t *capCoord = pPiece[coord];
 
     materialStrength[piece.Player()] -= piece.Worth();
-    totalStrength -= piece.Worth();
+    positionalStrength[piece.Player()] -=
+        gPreCalc.pst[piece.ToIndex()] [coord];
+    materialKey -= gPreCalc.materialKey[piece.ToIndex()] [coord];
+    if (piece.IsPawn())
+        pawnZobrist ^= gPreCalc.zobrist.coord[piece.ToIndex()] [coord];
 
     // change coord in pieceList and dec pieceList lgh.
     *capCoord = pieceCoords[piece.ToIndex()].back();
@@ -140,6 +150,13 @@ void PrivBoard::movePiece(cell_t src, cell_t dst, Piece piece)
     // Modify the pointer info in pPiece,
     // and the coords in the pieceList.
     *(pPiece[dst] = pPiece[src]) = dst;
+    const PhasedScoreT *pst = gPreCalc.pst[piece.ToIndex()];
+    positionalStrength[piece.Player()] += pst[dst] - pst[src];
+    if (piece.IsPawn())
+    {
+        pawnZobrist ^= gPreCalc.zobrist.coord[piece.ToIndex()] [src] ^
+            gPreCalc.zobrist.coord[piece.ToIndex()] [dst];
+    }
     updateCoord(dst, piece);
 
     // These last two bits are technically unnecessary when we are unmaking a
@@ -183,6 +200,43 @@ uint64 PrivBoard::calcZobrist() const
     return retVal;
 }
 
+// Like calcZobrist(), but for the material key.
+uint64 PrivBoard::calcMaterialKey() const
+{
+    uint64 retVal = 0;
+
+    for (int i = 0; i < NUM_SQUARES; i++)
+        retVal += gPreCalc.materialKey[PieceAt(i).ToIndex()] [i];
+    return retVal;
+}
+
+// Like calcZobrist(), but for the pawns only.
+uint64 PrivBoard::calcPawnZobrist() const
+{
+    uint64 retVal = 0;
+
+    for (int i = 0; i < NUM_SQUARES; i++)
+    {
+        if (PieceAt(i).IsPawn())
+            retVal ^= gPreCalc.zobrist.coord[PieceAt(i).ToIndex()] [i];
+    }
+    return retVal;
+}
+
+// Like calcZobrist(), but for the positional strength of 'player'.
+PhasedScoreT PrivBoard::calcPositionalStrength(uint8 player) const
+{
+    PhasedScoreT retVal = {0, 0};
+
+    for (int i = 0; i < NUM_SQUARES; i++)
+    {
+        Piece piece = PieceAt(i);
+        if (!piece.IsEmpty() && piece.Player() == player)
+            retVal += gPreCalc.pst[piece.ToIndex()] [i];
+    }
+    return retVal;
+}
+
 static inline uint8 calcCByteFromSrcDst(uint8 cbyte, uint8 src, uint8 dst)
 {
     return cbyte == 0 ? 0 :
@@ -333,6 +387,54 @@ bool Board::ConsistencyCheck(const char *failString) const
         assert(0);
         return false;
     }
+    if (materialKey != priv->calcMaterialKey())
+    {
+        LOG_EMERG("Board::ConsistencyCheck(%s): failure in material key calc "
+                  "(%" PRIx64 ", %" PRIx64 ").\n",
+                  failString, materialKey, priv->calcMaterialKey());
+        Log(eLogEmerg);
+        assert(0);
+        return false;
+    }
+    if (pawnZobrist != priv->calcPawnZobrist())
+    {
+        LOG_EMERG("Board::ConsistencyCheck(%s): failure in pawn zobrist calc "
+                  "(%" PRIx64 ", %" PRIx64 ").\n",
+                  failString, pawnZobrist, priv->calcPawnZobrist());
+        Log(eLogEmerg);
+        assert(0);
+        return false;
+    }
+    for (i = 0; i < NUM_PLAYERS; i++)
+    {
+        if (positionalStrength[i] != priv->calcPositionalStrength(i))
+        {
+            LOG_EMERG("Board::ConsistencyCheck(%s): failure in positional "
+                      "strength calc for player %d (%d/%d, %d/%d).\n",
+                      failString, i,
+                      positionalStrength[i].mg, positionalStrength[i].eg,
+                      priv->calcPositionalStrength(i).mg,
+                      priv->calcPositionalStrength(i).eg);
+            Log(eLogEmerg);
+            assert(0);
+            return false;
+        }
+    }
+    if (NnueNetId() != 0 && unmakes.size() < accumulators.size() &&
+        accumulators[unmakes.size()].netId == NnueNetId())
+    {
+        NnueAccumulatorT acc;
+        NnueRefresh(acc, *this);
+        if (memcmp(acc.values, accumulators[unmakes.size()].values,
+                   sizeof(acc.values)) != 0)
+        {
+            LOG_EMERG("Board::ConsistencyCheck(%s): failure in NNUE "
+                      "accumulator.\n", failString);
+            Log(eLogEmerg);
+            assert(0);
+            return false;
+        }
+    }
     return true;
 }
 
@@ -345,6 +447,8 @@ void PrivBoard::setEmptyBoard()
     
     ncheck = FLAG;
     zobrist = 0;
+    materialKey = 0;
+    pawnZobrist = 0;
     for (i = NUM_PLAYERS; i < kMaxPieces; i++)
     {
         // Start at NUM_PLAYERS since "Empty" pieces are not tracked.
@@ -357,10 +461,10 @@ void PrivBoard::setEmptyBoard()
     {
         pPiece[i] = nullptr;
     }
-    totalStrength = 0;
     for (i = 0; i < NUM_PLAYERS; i++)
     {
         materialStrength[i] = 0;
+        positionalStrength[i] = PhasedScoreT{0, 0};
     }
     repeatPly = -1;
 
@@ -371,6 +475,7 @@ void PrivBoard::setEmptyBoard()
     }
 
     unmakes.resize(0);
+    accumulators.clear();
 }
 
 // This is currently optimized for sanity and reuse, not speed.
@@ -387,8 +492,8 @@ bool Board::SetPosition(const class Position &position)
     // Copy over the position proper
     Position::operator=(position);
 
-    // Populate pieceCoords vector array, pPiece, totalStrength, and
-    //  materialStrength.
+    // Populate pieceCoords vector array, pPiece, materialStrength,
+    //  positionalStrength, materialKey, and pawnZobrist.
     for (int i = 0; i < NUM_SQUARES; i++)
     {
         if (!PieceAt(i).IsEmpty())
@@ -550,6 +655,53 @@ void PrivBoard::doCastleMove(uint8 kSrc, uint8 kDst,
     addPiece(kDst, kPiece);
 }
 
+// Updates the NNUE accumulator after the pieces for 'unmake.move' have been
+//  moved (but before the turn changes).
+void PrivBoard::updateAccumulator(const UnMakeT &unmake)
+{
+    int idx = unmakes.size();
+    if (int(accumulators.size()) <= idx)
+        accumulators.resize(idx + 1);
+    NnueAccumulatorT &acc = accumulators[idx];
+    const NnueAccumulatorT &parent = accumulators[idx - 1];
+
+    if (parent.netId != NnueNetId())
+    {
+        // Nothing to update from.  Accumulator() will catch up if needed.
+        acc.netId = 0;
+        return;
+    }
+
+    MoveT move = unmake.move;
+    NnueDirtyT dirty;
+    dirty.count = 0;
+    if (move.IsCastle())
+    {
+        cell_t kSrc, kDst, rSrc, rDst;
+        populateCastleCoords(move.IsCastleOO(), kSrc, kDst, rSrc, rDst);
+        dirty.Add(Piece(turn, PieceType::King), kSrc, kDst);
+        if (rSrc != rDst)
+            dirty.Add(Piece(turn, PieceType::Rook), rSrc, rDst);
+    }
+    else
+    {
+        if (move.IsPromote())
+        {
+            dirty.Add(Piece(turn, PieceType::Pawn), move.src, FLAG);
+            dirty.Add(PieceAt(move.dst), FLAG, move.dst);
+        }
+        else
+        {
+            dirty.Add(PieceAt(move.dst), move.src, move.dst);
+        }
+        if (!unmake.capPiece.IsEmpty())
+            dirty.Add(unmake.capPiece, move.dst, FLAG);
+        else if (move.IsEnPassant())
+            dirty.Add(Piece(turn ^ 1, PieceType::Pawn), ebyte, FLAG);
+    }
+    NnueUpdate(acc, parent, dirty, *this);
+}
+
 void Board::MakeMove(MoveT move)
 {
     PrivBoard *priv = static_cast<PrivBoard *>(this);
@@ -649,6 +801,9 @@ void Board::MakeMove(MoveT move)
         }
     }
 
+    if (NnueNetId() != 0)
+        priv->updateAccumulator(unmake);
+
     cbyte = newcbyte;
     ebyte = newebyte;
     ply++;
@@ -845,34 +1000,8 @@ bool Board::IsNormalStartingPosition() const
 
 bool Board::IsDrawInsufficientMaterial() const
 {
-    int b1, b2;
-
-    if (
-        // K vs k
-        totalStrength == 0 ||
-
-        // (KN or KB) vs k
-        (totalStrength == Eval::Knight &&
-         !PieceExists(Piece(0, PieceType::Pawn)) &&
-         !PieceExists(Piece(1, PieceType::Pawn))))
-    {
-        return true;
-    }
-
-    if (
-        // KB vs kb, bishops on same color
-        totalStrength == (Eval::Bishop << 1) &&
-        PieceCoords(Piece(0, PieceType::Bishop)).size() == 1 &&
-        PieceCoords(Piece(1, PieceType::Bishop)).size() == 1)
-    {
-        b1 = PieceCoords(Piece(0, PieceType::Bishop))[0];
-        b2 = PieceCoords(Piece(1, PieceType::Bishop))[0];
-        return
-            !((Rank(b1) + File(b1) +
-               Rank(b2) + File(b2)) & 1);
-    }
-
-    return false;
+    // (K vs k, (KN or KB) vs k, or KB vs kb w/bishops on the same color.)
+    return MaterialLookup(materialKey).IsDrawInsufficientMaterial();
 }
 
 
@@ -963,6 +1092,23 @@ int Board::CalcCapWorth(MoveT move) const
     return capWorth;
 }
 
+int Board::FirstOccurrencePly(int targetPly) const
+{
+    uint64 posZobrist = targetPly == ply ? zobrist :
+        positions[targetPly & (kNumSavedPositions - 1)].zobrist;
+    int result = targetPly;
+
+    // (We only remember so many positions.)
+    for (int myPly = targetPly - 4;
+         myPly >= ply - ncpPlies && myPly > ply - kNumSavedPositions;
+         myPly -= 2)
+    {
+        if (positions[myPly & (kNumSavedPositions - 1)].zobrist == posZobrist)
+            result = myPly;
+    }
+    return result;
+}
+
 bool Board::IsLegalMove(MoveT move) const
 {
     MoveList moveList;
@@ -18,14 +18,33 @@
 #include <vector>
 
 #include "aTypes.h"
+#include "Material.h"
 #include "move.h"
+#include "Nnue.h"
 #include "Piece.h"
 #include "Position.h"
+#include "Pst.h"
 #include "ref.h"
 #include "TransTable.h"
 
 class MoveList; // forward declaration for GenerateLegalMoves()
 
+// Attack information for both sides, as filled in by Board::GenerateAttacks().
+// Masks have one bit per coord (bit 0 == a1).
+struct AttackInfoT
+{
+    uint64 attacks[NUM_PLAYERS]; // every square each side attacks.
+    // Mobility of each side's pieces, by type.  This counts the squares each
+    //  piece attacks (except those occupied by its own side, or attacked by
+    //  enemy pawns).  Pinned pieces only count moves along the pin.  Pawn and
+    //  king mobility are not counted.
+    int mobility[NUM_PLAYERS] [int(PieceType::Queen) + 1];
+    // Number of each side's pieces (by type) attacking the enemy king zone
+    //  (the enemy king's square, plus every square next to it).  Pawns and
+    //  kings are not counted.
+    int kingZoneAttackers[NUM_PLAYERS] [int(PieceType::Queen) + 1];
+};
+
 // Using protected inheritance since we do not want to give the user the ability
 //  to (easily) set a board to an illegal position.
 class Board : protected Position
@@ -79,6 +98,11 @@ public:
     inline bool CanCastle(uint8 turn) const;
 
     inline uint64 Zobrist() const; // Returns current zobrist hash.
+    // Returns current material key (a signature of the material on the
+    //  board, see Material.h).
+    inline uint64 MaterialKey() const;
+    // Returns current pawn hash (a zobrist hash of just the pawns).
+    inline uint64 PawnZobrist() const;
     
     // Return a vector of all the coords inhabited by 'piece'.
     inline const std::vector<cell_t> &PieceCoords(Piece piece) const;
@@ -96,7 +120,17 @@ public:
     inline int MaterialStrength(uint8 player) const;
     // Syntactic sugar; relative strength of player vs all other player(s).
     inline int RelativeMaterialStrength() const;
-
+    // Positional (piece-square table) score of the side to move vs all other
+    //  player(s).  Like material, this is incrementally updated (as separate
+    //  middlegame and endgame scores, which are blended here according to the
+    //  game phase of the current material).
+    inline int PositionalScore() const;
+
+    // NNUE accumulator for the current position.  Only meaningful while a
+    //  network is loaded (see Nnue.h).  MakeMove() updates this incrementally
+    //  (UnmakeMove() just drops back to the previous one), but if it is
+    //  stale (say, the network was loaded mid-game) it is recalculated here.
+    inline const NnueAccumulatorT &Accumulator() const;
     // Ply that we can UnmakeMove() to.
     inline int BasePly() const;
     // Returns the last ply that this board has in common with 'other' (or
@@ -107,12 +141,23 @@ public:
     //  then this is the ply of the 1st repeat, not the original position.
     // If there is no repeated position, this is -1.
     inline int RepeatPly() const;
+    // Returns: the ply the position at 'targetPly' first occurred at (since
+    //  the last capture or pawn move), which is 'targetPly' itself if it is
+    //  not a repeat.  'targetPly' may not be before the last capture or pawn
+    //  move.  This is (relatively) slow.
+    int FirstOccurrencePly(int targetPly) const;
 
     // Generate all legal moves, and store them in 'mvlist'.  (Iff
     //  'generateCapturesOnly' == true *and* we are not in check, then
     //  generates capture moves only.)
     void GenerateLegalMoves(MoveList &mvlist, bool generateCapturesOnly) const;
 
+    // A cheaper "attacks only" generator, meant for the evaluation of nodes
+    //  that will not generate moves.  It shares the move generator's attack
+    //  tables and pin detection, but works for both sides at once, and does
+    //  not care about legality (beyond pins).
+    void GenerateAttacks(AttackInfoT &info) const;
+
     bool IsLegalMove(MoveT move) const;
     
     void Log(LogLevelT level) const;
@@ -131,6 +176,9 @@ protected:
     cell_t ncheck;
 
     uint64 zobrist;  // zobrist hash.  Incrementally updated w/each move.
+    uint64 materialKey; // material key.  Also incrementally updated.
+    uint64 pawnZobrist; // zobrist hash of just the pawns.  Also incrementally
+                        //  updated.
 
     // This is a way to quickly look up the number and location of any
     // type of piece on the board.
@@ -141,11 +189,10 @@ protected:
                                  //  this coord.  Basically a reverse lookup for
                                  //  'pieceCoords'.
 
-    int totalStrength; // material strength of all pieces combined.  Used when
-                       // checking for draws.
-
     // Material (not positional) strength of each side.
     int materialStrength[NUM_PLAYERS];
+    // Positional strength of each side (see PositionalScore()).
+    PhasedScoreT positionalStrength[NUM_PLAYERS];
 
     // Ply of first repeated position (if any, then the occurence of the 1st
     // repeat, not the original), otherwise -1).
@@ -187,6 +234,11 @@ protected:
     
     std::vector<UnMakeT> unmakes; 
 
+    // NNUE accumulators, indexed by unmakes.size() (so the current one is
+    //  last).  This may be bigger than necessary, or (when no network is
+    //  loaded) smaller.
+    mutable std::vector<NnueAccumulatorT> accumulators;
+
 private:
     cell_t calcNCheck(const char *context) const;
     const TransTable *transTable;
@@ -241,6 +293,16 @@ inline uint64 Board::Zobrist() const
     return zobrist;
 }
 
+inline uint64 Board::MaterialKey() const
+{
+    return materialKey;
+}
+
+inline uint64 Board::PawnZobrist() const
+{
+    return pawnZobrist;
+}
+
 inline const std::vector<cell_t> &Board::PieceCoords(Piece piece) const
 {
     return pieceCoords[piece.ToIndex()];
@@ -277,6 +339,22 @@ inline int Board::RelativeMaterialStrength() const
     return materialStrength[turn] - materialStrength[turn ^ 1];
 }
 
+inline int Board::PositionalScore() const
+{
+    return (positionalStrength[turn] - positionalStrength[turn ^ 1])
+        .Blend(MaterialLookup(materialKey).phase);
+}
+
+inline const NnueAccumulatorT &Board::Accumulator() const
+{
+    if (accumulators.size() <= unmakes.size())
+        accumulators.resize(unmakes.size() + 1);
+    NnueAccumulatorT &acc = accumulators[unmakes.size()];
+    if (acc.netId != NnueNetId())
+        NnueRefresh(acc, *this);
+    return acc;
+}
+
 inline int Board::BasePly() const
 {
     return Ply() - unmakes.size();
@@ -12,6 +12,7 @@
 //--------------------------------------------------------------------------
 
 #include <assert.h>
+#include <string.h> // memset(3)
 
 #include "Board.h"
 #include "gPreCalc.h"
@@ -49,6 +50,7 @@ class PrivBoard : public Board
 {
 public:
     void GenerateLegalMoves(MoveList &mvlist, bool generateCapturesOnly) const;
+    void GenerateAttacks(AttackInfoT &info) const;
     bool attacked(CoordListT *attList, int from, uint8 turn, int onwho) const;
 private:
     void addMoveCalcChk(MoveList &mvlist, cell_t from, cell_t to,
@@ -83,6 +85,9 @@ private:
     bool castleAttacked(cell_t src, cell_t dest) const;
     void findpins(PinsT &pinList, int kcoord, uint8 turn) const;
     void gendclist(PinsT &dcList, cell_t ekcoord, uint8 turn) const;
+    void slideAttacks(AttackInfoT &info, cell_t from, uint8 pintype,
+                      const int *dirs, uint64 notMobile, uint64 kingZone)
+        const;
 };
 
 } // end unnamed namespace
@@ -959,6 +964,128 @@ void PrivBoard::GenerateLegalMoves(MoveList &mvlist,
     // But, probably will do good when we extend captures.
 }
     
+// Adds the attacks of the bishop/rook/queen at 'from' to 'info'.  'dirs' is
+//  FLAG-terminated.  Squares in 'notMobile' do not count toward mobility.
+void PrivBoard::slideAttacks(AttackInfoT &info, cell_t from, uint8 pintype,
+                             const int *dirs, uint64 notMobile,
+                             uint64 kingZone) const
+{
+    Piece myPiece(PieceAt(from));
+    uint8 player = myPiece.Player();
+    int type = int(myPiece.Type());
+    uint64 attacks = 0;
+    int mobility = 0;
+    cell_t to;
+
+    do
+    {
+        bool canMove = pintype == FLAG || pintype == ((*dirs) & 3);
+        for (const cell_t *moves = gPreCalc.moves[*dirs] [from];
+             (to = *moves) != FLAG;
+             moves++)
+        {
+            attacks |= uint64(1) << to;
+            if (canMove && !(notMobile & (uint64(1) << to)) &&
+                !PieceAt(to).IsSelf(player))
+            {
+                mobility++;
+            }
+            if (!PieceAt(to).IsEmpty())
+                break; // Occupied.  Can't probe further.
+        }
+    } while (*(++dirs) != FLAG);
+
+    info.attacks[player] |= attacks;
+    info.mobility[player] [type] += mobility;
+    if (attacks & kingZone)
+        info.kingZoneAttackers[player] [type]++;
+}
+
+void PrivBoard::GenerateAttacks(AttackInfoT &info) const
+{
+    static const int kBishopDirs[] = {0, 2, 4, 6, FLAG};
+    static const int kRookDirs[] = {1, 3, 5, 7, FLAG};
+    static const int kQueenDirs[] = {0, 1, 2, 3, 4, 5, 6, 7, FLAG};
+    uint64 kingZone[NUM_PLAYERS], pawnAttacks[NUM_PLAYERS];
+    cell_t to;
+
+    memset(&info, 0, sizeof(info));
+
+    // Pawn and king attacks come first, since they are needed to calculate
+    //  the mobility (and king zone attacks) of everything else.
+    for (uint8 player = 0; player < NUM_PLAYERS; player++)
+    {
+        cell_t kcoord = PieceCoords(Piece(player, PieceType::King))[0];
+
+        kingZone[player] = uint64(1) << kcoord;
+        for (int dir = 0; dir < 8; dir++)
+        {
+            if ((to = *gPreCalc.moves[dir] [kcoord]) != FLAG)
+                kingZone[player] |= uint64(1) << to;
+        }
+        info.attacks[player] = kingZone[player] & ~(uint64(1) << kcoord);
+
+        pawnAttacks[player] = 0;
+        for (cell_t coord : PieceCoords(Piece(player, PieceType::Pawn)))
+        {
+            // (The first two entries are the capturing moves.)
+            const cell_t *moves = gPreCalc.moves[10 + player] [coord];
+            for (int i = 0; i < 2; i++)
+            {
+                if (moves[i] != FLAG)
+                    pawnAttacks[player] |= uint64(1) << moves[i];
+            }
+        }
+        info.attacks[player] |= pawnAttacks[player];
+    }
+
+    for (uint8 player = 0; player < NUM_PLAYERS; player++)
+    {
+        PinsT pinlist;
+        uint64 notMobile = pawnAttacks[player ^ 1];
+        uint64 enemyKingZone = kingZone[player ^ 1];
+
+        findpins(pinlist, PieceCoords(Piece(player, PieceType::King))[0],
+                 player);
+
+        for (cell_t coord : PieceCoords(Piece(player, PieceType::Knight)))
+        {
+            uint64 attacks = 0;
+            for (const cell_t *moves = gPreCalc.moves[8] [coord];
+                 (to = *moves) != FLAG;
+                 moves++)
+            {
+                attacks |= uint64(1) << to;
+                // A pinned knight cannot move w/out checking its king.
+                if (pinlist.c[coord] == FLAG &&
+                    !(notMobile & (uint64(1) << to)) &&
+                    !PieceAt(to).IsSelf(player))
+                {
+                    info.mobility[player] [int(PieceType::Knight)]++;
+                }
+            }
+            info.attacks[player] |= attacks;
+            if (attacks & enemyKingZone)
+                info.kingZoneAttackers[player] [int(PieceType::Knight)]++;
+        }
+        for (cell_t coord : PieceCoords(Piece(player, PieceType::Bishop)))
+        {
+            slideAttacks(info, coord, pinlist.c[coord], kBishopDirs,
+                         notMobile, enemyKingZone);
+        }
+        for (cell_t coord : PieceCoords(Piece(player, PieceType::Rook)))
+        {
+            slideAttacks(info, coord, pinlist.c[coord], kRookDirs,
+                         notMobile, enemyKingZone);
+        }
+        for (cell_t coord : PieceCoords(Piece(player, PieceType::Queen)))
+        {
+            slideAttacks(info, coord, pinlist.c[coord], kQueenDirs,
+                         notMobile, enemyKingZone);
+        }
+    }
+}
+
 cell_t Board::calcNCheck(const char *context) const
 {
     CoordListT attList;
@@ -997,3 +1124,9 @@ void Board::GenerateLegalMoves(MoveList &mvlist,
     const PrivBoard *priv = static_cast<const PrivBoard *>(this);
     priv->GenerateLegalMoves(mvlist, generateCapturesOnly);
 }
+
+void Board::GenerateAttacks(AttackInfoT &info) const
+{
+    const PrivBoard *priv = static_cast<const PrivBoard *>(this);
+    priv->GenerateAttacks(info);
+}
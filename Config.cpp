@@ -23,6 +23,10 @@ const char *const Config::MaxMemorySpin = "limits/maxMemory";
 const char *const Config::MaxMemoryDescription =
     "Max cumulative size of transposition table + other adjustable caches (in MiB).";
 
+const char *const Config::EvalCacheSpin = "limits/evalCacheMemory";
+const char *const Config::EvalCacheDescription =
+    "Size of the static evaluation cache (in MiB).  0 disables it.";
+
 const char *const Config::MaxNodesSpin = "limits/maxNodes";
 const char *const Config::MaxNodesDescription =
     "Max nodes engine may search.  0 implies 'no limit'.";
@@ -39,10 +43,46 @@ const char *const Config::CanResignCheckbox = "canResign";
 const char *const Config::CanResignDescription =
     "True iff engine may resign.";
 
+const char *const Config::HashDiagnosticsCheckbox = "hashDiagnostics";
+const char *const Config::HashDiagnosticsDescription =
+    "True iff engine should check transposition table hits for key "
+    "collisions (slow).";
+
+const char *const Config::HashMinDepthSpin = "hashMinDepth";
+const char *const Config::HashMinDepthDescription =
+    "Shallowest search depth the transposition table keeps results for.  "
+    "Quiescing results always go to a small per-thread table instead; -1 "
+    "keeps them in the transposition table, too.";
+
 const char *const Config::HistoryWindowSpin = "historyWindow";
 const char *const Config::HistoryWindowDescription =
     "History heuristic (0 -> disabled, 1 -> killer moves, etc.)";
 
+const char *const Config::LazyEvalMarginSpin = "lazyEvalMargin";
+const char *const Config::LazyEvalMarginDescription =
+    "How far (in centipawns) outside the search window a quiescing node's "
+    "material + piece-square score must be to skip the rest of the "
+    "evaluation.  0 implies 'always evaluate fully'.";
+
+const char *const Config::EvalFileString = "evalFile";
+const char *const Config::EvalFileDescription =
+    "NNUE network file to evaluate with.  Empty implies 'use the built-in "
+    "evaluation'.";
+
+const char *const Config::HashFileString = "hashFile";
+const char *const Config::HashFileDescription =
+    "File that saveHash writes the transposition table to, and loadHash "
+    "reads it from.";
+
+const char *const Config::SaveHashButton = "saveHash";
+const char *const Config::SaveHashDescription =
+    "Saves the transposition table to hashFile.";
+
+const char *const Config::LoadHashButton = "loadHash";
+const char *const Config::LoadHashDescription =
+    "Loads the transposition table (and its size) from hashFile.  A new game "
+    "clears it, so load it afterwards.";
+
 const char *Config::ErrorString(Config::Error error) const
 {
     switch (error)
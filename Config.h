@@ -36,11 +36,19 @@ public:
     static const char
         *const MaxDepthSpin, *const MaxDepthDescription,
         *const MaxMemorySpin, *const MaxMemoryDescription,
+        *const EvalCacheSpin, *const EvalCacheDescription,
         *const MaxNodesSpin, *const MaxNodesDescription,
         *const MaxThreadsSpin, *const MaxThreadsDescription,
         *const RandomMovesCheckbox, *const RandomMovesDescription,
         *const CanResignCheckbox, *const CanResignDescription,
-        *const HistoryWindowSpin, *const HistoryWindowDescription;
+        *const HashDiagnosticsCheckbox, *const HashDiagnosticsDescription,
+        *const HashMinDepthSpin, *const HashMinDepthDescription,
+        *const HistoryWindowSpin, *const HistoryWindowDescription,
+        *const LazyEvalMarginSpin, *const LazyEvalMarginDescription,
+        *const EvalFileString, *const EvalFileDescription,
+        *const HashFileString, *const HashFileDescription,
+        *const SaveHashButton, *const SaveHashDescription,
+        *const LoadHashButton, *const LoadHashDescription;
     
     Config() = default;
     Config(const Config &other) = default;
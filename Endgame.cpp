@@ -0,0 +1,279 @@
+//--------------------------------------------------------------------------
+//              Endgame.cpp - specialized endgame evaluation.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#include <assert.h>
+#include <stdlib.h> // abs(3)
+#include <string.h>
+#include <unordered_map>
+
+#include "Endgame.h"
+#include "Eval.h"
+#include "gPreCalc.h"
+
+using arctic::File;
+using arctic::Rank;
+
+// Scale factors (see EndgameScale()) are out of this.
+static const int kScaleNormal = 64;
+
+// On top of the material, for endgames that are (basically) won.  This
+//  makes a won endgame always look better than a merely good one.
+static const int kWinBonus = 200;
+
+namespace // start unnamed namespace
+{
+
+struct RegistryEntryT
+{
+    EndgameT endgame;
+    uint8 strongSide;
+};
+
+// Maps material keys to endgames.
+class EndgameRegistry
+{
+public:
+    EndgameRegistry();
+    inline const RegistryEntryT *Find(uint64 key) const;
+private:
+    std::unordered_map<uint64, RegistryEntryT> entries;
+    void add(const char *code, EndgameT endgame);
+};
+
+} // end unnamed namespace
+
+EndgameRegistry::EndgameRegistry()
+{
+    add("KBNK", EndgameT::KBNK);
+    add("KQKR", EndgameT::KQKR);
+    add("KRKB", EndgameT::KRKMinor);
+    add("KRKN", EndgameT::KRKMinor);
+    add("KPK",  EndgameT::KPK);
+    // (Not an insufficient material draw, but mate cannot be forced.)
+    add("KNNK", EndgameT::DrawishPawnless);
+}
+
+// Registers 'endgame' for the material in 'code' (say, "KBNK"; the strong
+//  side's pieces come first), with either side as the strong side, and with
+//  the bishops on any square colors.
+void EndgameRegistry::add(const char *code, EndgameT endgame)
+{
+    static const char kPieceChars[] = "PNBRQ";
+    static const PieceType kPieceTypes[] =
+        {PieceType::Pawn, PieceType::Knight, PieceType::Bishop,
+         PieceType::Rook, PieceType::Queen};
+    int numBishops = 0;
+
+    assert(code[0] == 'K' && strchr(code + 1, 'K') != nullptr);
+    for (const char *p = code; *p; p++)
+        numBishops += *p == 'B';
+
+    for (uint8 strongSide = 0; strongSide < NUM_PLAYERS; strongSide++)
+    {
+        for (int colors = 0; colors < (1 << numBishops); colors++)
+        {
+            uint64 key = 0;
+            uint8 player = strongSide;
+            int bishop = 0;
+
+            for (const char *p = code + 1; *p; p++)
+            {
+                if (*p == 'K')
+                {
+                    player ^= 1;
+                    continue;
+                }
+                PieceType type =
+                    kPieceTypes[strchr(kPieceChars, *p) - kPieceChars];
+                // (a1 is dark, b1 is light.  The coord does not matter for
+                //  other pieces.)
+                cell_t coord =
+                    type == PieceType::Bishop && (colors & (1 << bishop++)) ?
+                    1 : 0;
+                key += MaterialKeyInc(Piece(player, type), coord);
+            }
+            entries[key] = RegistryEntryT{endgame, strongSide};
+        }
+    }
+}
+
+inline const RegistryEntryT *EndgameRegistry::Find(uint64 key) const
+{
+    auto it = entries.find(key);
+    return it == entries.end() ? nullptr : &it->second;
+}
+
+EndgameT EndgameLookup(uint64 key, uint8 *strongSide)
+{
+    static const EndgameRegistry registry;
+    const RegistryEntryT *entry = registry.Find(key);
+
+    *strongSide = entry != nullptr ? entry->strongSide : 0;
+    return entry != nullptr ? entry->endgame : EndgameT::None;
+}
+
+static inline cell_t kingCoord(const Board &board, uint8 player)
+{
+    return board.PieceCoords(Piece(player, PieceType::King))[0];
+}
+
+// Returns: a bonus for driving the weak king (at 'weakKing') towards the edge
+//  and bringing our own king (at 'strongKing') close to it.
+static inline int mopUp(cell_t strongKing, cell_t weakKing)
+{
+    return gPreCalc.centerDistance[weakKing] * 10 +
+        (7 - gPreCalc.distance[strongKing] [weakKing]) * 4;
+}
+
+// KBNK: mate is only possible in the corners the bishop controls, so that is
+//  where the weak king must go.
+static int evalKBNK(const Board &board, uint8 strongSide)
+{
+    cell_t strongKing = kingCoord(board, strongSide);
+    cell_t weakKing = kingCoord(board, strongSide ^ 1);
+    cell_t bishop =
+        board.PieceCoords(Piece(strongSide, PieceType::Bishop))[0];
+    bool darkBishop = !((Rank(bishop) + File(bishop)) & 1);
+    // (a1 and h8 are dark; h1 and a8 are light.)
+    cell_t corner1 = darkBishop ? 0 : 7, corner2 = darkBishop ? 63 : 56;
+    int cornerDistance = MIN(gPreCalc.distance[weakKing] [corner1],
+                             gPreCalc.distance[weakKing] [corner2]);
+
+    return Eval::Knight + Eval::Bishop + kWinBonus +
+        (7 - cornerDistance) * 30 +
+        (7 - gPreCalc.distance[strongKing] [weakKing]) * 10;
+}
+
+// KQKR: a win, though it takes technique.  Drive the king to the edge, and
+//  (hopefully) the rook gets separated from it.
+static int evalKQKR(const Board &board, uint8 strongSide)
+{
+    return Eval::Queen - Eval::Rook + kWinBonus +
+        2 * mopUp(kingCoord(board, strongSide),
+                  kingCoord(board, strongSide ^ 1));
+}
+
+// KR vs KB or KN: usually a draw, so we do not give the rook much credit.
+//  But a cornered king (or a knight far away from its king) can still lose.
+static int evalKRKMinor(const Board &board, uint8 strongSide)
+{
+    cell_t weakKing = kingCoord(board, strongSide ^ 1);
+    int result = (Eval::Rook - Eval::Knight) / 4 +
+        mopUp(kingCoord(board, strongSide), weakKing) / 2;
+
+    const std::vector<cell_t> &knights =
+        board.PieceCoords(Piece(strongSide ^ 1, PieceType::Knight));
+    if (!knights.empty())
+        result += gPreCalc.distance[weakKing] [knights[0]] * 8;
+    return result;
+}
+
+// KPK: the pawn promotes if the weak king is outside the "square" of the
+//  pawn.  Otherwise, the weak king in front of the pawn (or in the corner, for
+//  a rook pawn) usually draws, and the strong king in front of it usually
+//  wins.
+static int evalKPK(const Board &board, uint8 strongSide)
+{
+    cell_t strongKing = kingCoord(board, strongSide);
+    cell_t weakKing = kingCoord(board, strongSide ^ 1);
+    cell_t pawn = board.PieceCoords(Piece(strongSide, PieceType::Pawn))[0];
+    int file = File(pawn);
+    int rank = strongSide == 0 ? Rank(pawn) : 7 - Rank(pawn); // relative
+    cell_t queeningCoord = strongSide == 0 ? 56 + file : file;
+    // (A pawn on its starting rank can move two squares.)
+    int pawnDistance = MIN(7 - rank, 5);
+    int weakKingDistance = gPreCalc.distance[weakKing] [queeningCoord] -
+        (board.Turn() != strongSide);
+    bool kingInTheWay = File(strongKing) == file &&
+        (strongSide == 0 ? Rank(strongKing) > Rank(pawn) :
+         Rank(strongKing) < Rank(pawn));
+
+    if (weakKingDistance > pawnDistance && !kingInTheWay)
+        return Eval::Queen - Eval::Pawn + kWinBonus - pawnDistance * 10;
+
+    int weakKingRank =
+        strongSide == 0 ? Rank(weakKing) : 7 - Rank(weakKing); // relative
+    int strongKingRank =
+        strongSide == 0 ? Rank(strongKing) : 7 - Rank(strongKing);
+    if ((file == 0 || file == 7) &&
+        gPreCalc.distance[weakKing] [queeningCoord] <= 1)
+    {
+        return 0;
+    }
+    if (File(weakKing) == file && weakKingRank > rank &&
+        strongKingRank <= rank)
+    {
+        return Eval::Pawn / 4;
+    }
+
+    int result = Eval::Pawn + rank * 20 +
+        (gPreCalc.distance[weakKing] [pawn] -
+         gPreCalc.distance[strongKing] [pawn]) * 10;
+    // Our king is in front of the pawn: often a win.
+    if (strongKingRank > rank && abs(File(strongKing) - file) <= 1)
+        result += kWinBonus / 2;
+    return result;
+}
+
+int EndgameEvaluate(const Board &board, const MaterialInfoT &material)
+{
+    uint8 strongSide = material.strongSide;
+    int result;
+
+    switch (material.endgame)
+    {
+        case EndgameT::KBNK:
+            result = evalKBNK(board, strongSide);
+            break;
+        case EndgameT::KQKR:
+            result = evalKQKR(board, strongSide);
+            break;
+        case EndgameT::KRKMinor:
+            result = evalKRKMinor(board, strongSide);
+            break;
+        case EndgameT::KPK:
+            result = evalKPK(board, strongSide);
+            break;
+        default:
+            assert(0);
+            return 0;
+    }
+    return board.Turn() == strongSide ? result : -result;
+}
+
+// Returns: the number of pawns 'player' has.
+static inline int numPawns(const Board &board, uint8 player)
+{
+    return board.PieceCoords(Piece(player, PieceType::Pawn)).size();
+}
+
+int EndgameScale(int eval, const Board &board, const MaterialInfoT &material)
+{
+    int scale;
+
+    switch (material.endgame)
+    {
+        case EndgameT::OppositeBishops:
+            // Even two extra pawns are often not enough.
+            scale = abs(numPawns(board, 0) - numPawns(board, 1)) <= 2 ?
+                kScaleNormal / 4 : kScaleNormal / 2;
+            break;
+        case EndgameT::DrawishPawnless:
+            scale = kScaleNormal / 8;
+            break;
+        default:
+            assert(0);
+            return eval;
+    }
+    return eval * scale / kScaleNormal;
+}
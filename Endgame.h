@@ -0,0 +1,49 @@
+//--------------------------------------------------------------------------
+//               Endgame.h - specialized endgame evaluation.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include "aTypes.h"
+#include "Board.h"
+#include "Material.h"
+
+// Returns: the endgame registered for material key 'key' (EndgameT::None if
+//  there is none), and sets 'strongSide' to the side with the advantage.
+//  This is used to fill in MaterialInfoT, so the search itself just reads
+//  'material.endgame'.
+// Endgames that are recognized by a rule instead of by key (like opposite
+//  colored bishops) are left to the material table.
+EndgameT EndgameLookup(uint64 key, uint8 *strongSide);
+
+// Returns: true iff 'endgame' has a specialized evaluator.
+inline bool EndgameHasEvaluator(EndgameT endgame)
+{
+    return endgame >= EndgameT::KBNK && endgame <= EndgameT::KPK;
+}
+
+// Returns: true iff 'endgame' has a scaling function.
+inline bool EndgameHasScale(EndgameT endgame)
+{
+    return endgame >= EndgameT::OppositeBishops;
+}
+
+// Returns: the specialized evaluation of 'board', from the point of view of
+//  the side to move.  Requires EndgameHasEvaluator(material.endgame).
+int EndgameEvaluate(const Board &board, const MaterialInfoT &material);
+
+// Returns: 'eval' (the normal evaluation of 'board'), scaled towards a draw.
+//  Requires EndgameHasScale(material.endgame).
+int EndgameScale(int eval, const Board &board, const MaterialInfoT &material);
+
+#endif // ENDGAME_H
@@ -15,6 +15,8 @@
 
 #include "Engine.h"
 #include "HistoryWindow.h"
+#include "log.h"
+#include "Nnue.h"
 #include "Variant.h"
 
 /* Communication between the main program ("Engine" interface) and the Thinker
@@ -65,6 +67,18 @@ void Engine::onCanResignChanged(const Config::CheckboxItem &item)
         return;
     th->SharedContext().canResign = item.Value();
 }
+void Engine::onHashDiagnosticsChanged(const Config::CheckboxItem &item)
+{
+    if (!th->IsRootThinker())
+        return;
+    th->SharedContext().hashDiagnostics = item.Value();
+}
+void Engine::onHashMinDepthChanged(const Config::SpinItem &item)
+{
+    if (!th->IsRootThinker())
+        return;
+    th->SharedContext().transTable.SetMinDepth(item.Value());
+}
 void Engine::onHistoryWindowChanged(const Config::SpinItem &item)
 {
     if (!th->IsRootThinker())
@@ -100,10 +114,32 @@ void Engine::onMaxMemoryChanged(const Config::SpinItem &item)
     Thinker::State origState = state;
     if (IsBusy())
         CmdBail();
-    th->SharedContext().transTable.Reset(uint64(item.Value()) * 1024 * 1024);
+    // (This keeps the table's entries, and the search can keep using the old
+    //  table until the new one is ready.)
+    TransTable &transTable = th->SharedContext().transTable;
+    transTable.SetDesiredSize(uint64(item.Value()) * 1024 * 1024);
+    transTable.ResizeAsync(th->SharedContext().maxThreads);
+    restoreState(origState);
+}
+
+void Engine::onEvalCacheChanged(const Config::SpinItem &item)
+{
+    if (!th->IsRootThinker())
+        return;
+    Thinker::State origState = state;
+    if (IsBusy())
+        CmdBail();
+    th->SharedContext().evalCache.Reset(uint64(item.Value()) * 1024 * 1024);
     restoreState(origState);
 }
 
+void Engine::onLazyEvalMarginChanged(const Config::SpinItem &item)
+{
+    if (!th->IsRootThinker())
+        return;
+    th->SharedContext().lazyEvalMargin = item.Value();
+}
+
 void Engine::onMaxThreadsChanged(const Config::SpinItem &item)
 {
     if (!th->IsRootThinker())
@@ -116,6 +152,51 @@ void Engine::onMaxThreadsChanged(const Config::SpinItem &item)
     restoreState(origState);
 }
 
+void Engine::onEvalFileChanged(const Config::StringItem &item)
+{
+    if (!th->IsRootThinker())
+        return;
+    Thinker::State origState = state;
+    if (IsBusy())
+        CmdBail();
+    // (The network is shared by every thread.)
+    if (!NnueLoad(item.Value()))
+    {
+        LOG_NORMAL("%s: could not load '%s', using built-in evaluation\n",
+                   __func__, item.Value().c_str());
+    }
+    // Cached evals came from the old evaluator.
+    th->SharedContext().evalCache.Reset();
+    restoreState(origState);
+}
+
+void Engine::onHashFileChanged(const Config::StringItem &item)
+{
+    hashFile = item.Value();
+}
+
+void Engine::onSaveHash(const Config::ButtonItem &item)
+{
+    if (!th->IsRootThinker())
+        return;
+    Thinker::State origState = state;
+    if (IsBusy())
+        CmdBail();
+    th->SharedContext().transTable.Save(hashFile); // (logs any failure)
+    restoreState(origState);
+}
+
+void Engine::onLoadHash(const Config::ButtonItem &item)
+{
+    if (!th->IsRootThinker())
+        return;
+    Thinker::State origState = state;
+    if (IsBusy())
+        CmdBail();
+    th->SharedContext().transTable.Load(hashFile); // (logs any failure)
+    restoreState(origState);
+}
+
 // ctor.
 Engine::Engine() :
     rspQueue(std::unique_ptr<Pollable>(new Pollable)),
@@ -157,6 +238,18 @@ Engine::Engine() :
                              true,
                              std::bind(&Engine::onCanResignChanged, this,
                                        std::placeholders::_1)));
+    Config().Register(
+        Config::CheckboxItem(Config::HashDiagnosticsCheckbox,
+                             Config::HashDiagnosticsDescription,
+                             false,
+                             std::bind(&Engine::onHashDiagnosticsChanged, this,
+                                       std::placeholders::_1)));
+    Config().Register(
+        Config::SpinItem(Config::HashMinDepthSpin,
+                         Config::HashMinDepthDescription,
+                         -1, th->SharedContext().transTable.MinDepth(), 100,
+                         std::bind(&Engine::onHashMinDepthChanged, this,
+                                   std::placeholders::_1)));
     Config().Register(
         Config::SpinItem(Config::HistoryWindowSpin,
                          Config::HistoryWindowDescription,
@@ -171,12 +264,45 @@ Engine::Engine() :
                           (1024 * 1024)),
                          std::bind(&Engine::onMaxMemoryChanged, this,
                                    std::placeholders::_1)));
+    Config().Register(
+        Config::SpinItem(Config::EvalCacheSpin, Config::EvalCacheDescription,
+                         0, EvalCache::DefaultSize() / (1024 * 1024), 1024,
+                         std::bind(&Engine::onEvalCacheChanged, this,
+                                   std::placeholders::_1)));
+    Config().Register(
+        Config::SpinItem(Config::LazyEvalMarginSpin,
+                         Config::LazyEvalMarginDescription,
+                         0, th->SharedContext().lazyEvalMargin, 10000,
+                         std::bind(&Engine::onLazyEvalMarginChanged, this,
+                                   std::placeholders::_1)));
     Config().Register(
         Config::SpinItem(Config::MaxThreadsSpin, Config::MaxThreadsDescription,
                          1, th->SharedContext().maxThreads,
                          th->SharedContext().maxThreads,
                          std::bind(&Engine::onMaxThreadsChanged, this,
                                    std::placeholders::_1)));
+    Config().Register(
+        Config::StringItem(Config::EvalFileString,
+                           Config::EvalFileDescription,
+                           "",
+                           std::bind(&Engine::onEvalFileChanged, this,
+                                     std::placeholders::_1)));
+    Config().Register(
+        Config::StringItem(Config::HashFileString,
+                           Config::HashFileDescription,
+                           "",
+                           std::bind(&Engine::onHashFileChanged, this,
+                                     std::placeholders::_1)));
+    Config().Register(
+        Config::ButtonItem(Config::SaveHashButton,
+                           Config::SaveHashDescription,
+                           std::bind(&Engine::onSaveHash, this,
+                                     std::placeholders::_1)));
+    Config().Register(
+        Config::ButtonItem(Config::LoadHashButton,
+                           Config::LoadHashDescription,
+                           std::bind(&Engine::onLoadHash, this,
+                                     std::placeholders::_1)));
 }
 
 // dtor
@@ -193,7 +319,8 @@ void Engine::CmdNewGame()
     CmdBail();
     if (th->IsRootThinker())
     {
-        sharedContext.transTable.Reset();
+        sharedContext.transTable.ResetAsync(sharedContext.maxThreads);
+        sharedContext.evalCache.Reset();
         gHistoryWindow.Clear();
         sharedContext.pv.Clear();
         sharedContext.gameCount++;
@@ -327,6 +454,9 @@ void Engine::CmdMoveNow()
     if (IsBusy() && moveNowState == MoveNowState::IdleOrBusy)
     {
         moveNowState = MoveNowState::MoveNowRequested;
+        // (Signal directly so the search stops promptly; the posted command
+        //  covers a thinker that is blocked on its cmdqueue.)
+        th->SignalMoveNow();
         th->PostCmd(std::bind(&Thinker::OnCmdMoveNow, th.get()));
     }
 }
@@ -96,6 +96,7 @@ private:
     } moveNowState;
     class Config config;
     RspHandlerT rspHandler;
+    std::string hashFile; // see Config::HashFileString
 
     void doThink(bool isPonder, const MoveList *mvlist);
     void restoreState(Thinker::State state);
@@ -103,9 +104,17 @@ private:
     void onMaxNodesChanged(const Config::SpinItem &item);
     void onRandomMovesChanged(const Config::CheckboxItem &item);
     void onCanResignChanged(const Config::CheckboxItem &item);
+    void onHashDiagnosticsChanged(const Config::CheckboxItem &item);
+    void onHashMinDepthChanged(const Config::SpinItem &item);
     void onHistoryWindowChanged(const Config::SpinItem &item);
     void onMaxMemoryChanged(const Config::SpinItem &item);
+    void onEvalCacheChanged(const Config::SpinItem &item);
+    void onLazyEvalMarginChanged(const Config::SpinItem &item);
     void onMaxThreadsChanged(const Config::SpinItem &item);
+    void onEvalFileChanged(const Config::StringItem &item);
+    void onHashFileChanged(const Config::StringItem &item);
+    void onSaveHash(const Config::ButtonItem &item);
+    void onLoadHash(const Config::ButtonItem &item);
 
     void moveToIdleState();
     
@@ -17,20 +17,94 @@
 #include <string.h> // memset()
 #include "Pv.h"
 
+// Transposition table diagnostics (see TransTable and EngineStatsT).
+struct HashStatsT
+{
+    // Probes (IsHit() calls), hits (the position was found), and cutoffs (the
+    //  entry could be used instead of searching), by the search depth of the
+    //  probe.  Quiescing probes go in [0], and depth 'd' in [d + 1] (the last
+    //  one also counts anything deeper); see DepthIndex().
+    static const int kNumDepths = 8;
+    int probes[kNumDepths];
+    int hits[kNumDepths];
+    int cutoffs[kNumDepths];
+
+    // Why ConditionalUpdate() did (or did not) write an entry.
+    enum class Write
+    {
+        Empty,     // into an unused entry
+        Same,      // updated the position's own entry
+        Stale,     // replaced an entry from another search
+        Shallower, // replaced a shallower entry from this search
+        Skipped,   // kept what was there
+        NumWrites
+    };
+    int writes[int(Write::NumWrites)];
+
+    // Cutoffs whose move was not legal, meaning the entry really belonged to
+    //  a different position with the same key.  Only counted while the
+    //  (slow) check is enabled; see Config::HashDiagnosticsCheckbox.
+    int collisions;
+    // Hits that could not be used because the entry depended on how its
+    //  position was reached (see TransTable::ConditionalUpdate()).
+    int pathDependent;
+
+    // A sample of the entries at the start of the table (see
+    //  TransTable::SampleOccupancy()): how many were looked at, and of the
+    //  ones in use, how many searches ago they were last touched (the last
+    //  one also counts anything older).
+    static const int kNumAges = 4;
+    int sampled;
+    int ages[kNumAges];
+
+    static inline int DepthIndex(int searchDepth);
+    // Adds the counts (but not the occupancy sample) of 'other' to ours, and
+    //  returns the total number of cutoffs it had.
+    inline int AddCounts(const HashStatsT &other);
+};
+
+inline int HashStatsT::DepthIndex(int searchDepth)
+{
+    return searchDepth < 0 ? 0 : searchDepth + 1 < kNumDepths ?
+        searchDepth + 1 : kNumDepths - 1;
+}
+
+inline int HashStatsT::AddCounts(const HashStatsT &other)
+{
+    int totalCutoffs = 0;
+    for (int i = 0; i < kNumDepths; i++)
+    {
+        probes[i] += other.probes[i];
+        hits[i] += other.hits[i];
+        cutoffs[i] += other.cutoffs[i];
+        totalCutoffs += other.cutoffs[i];
+    }
+    for (int i = 0; i < int(Write::NumWrites); i++)
+        writes[i] += other.writes[i];
+    collisions += other.collisions;
+    pathDependent += other.pathDependent;
+    return totalCutoffs;
+}
+
 // NOTE: these are not exact counts, since we do not want the speed hit that
-//  comes from updating these atomically.  We could have the child threads
-//  maintain their own stats while they are searching, but this still does not
-//  work for 'nodes' because the children need to quickly know when maxNodes
-//  has been met.
+//  comes from updating these atomically.  'nodes' is the exception: each
+//  thinker counts its own nodes, and periodically adds them to an atomic total
+//  that 'nodes' is copied from (see Thinker::ReportNodes()), and that maxNodes
+//  is checked against.
 struct EngineStatsT
 {
     int nodes;        // node count (how many times was 'minimax' invoked)
     int nonQNodes;    // non-quiesce node count
     int moveGenNodes; // how many times was mListGenerate() called
     int hashHitGood;  // hashtable hits that returned immediately.
-    int hashWroteNew; // how many times (in this ply) we wrote to a unique
-                      //  hash entry.  Used for UCI hashfull stats.
     int hashFullPerMille; // how "full" is the hash (in parts per thousand).
+                          //  Only entries used by this search count.
+    int hashPageKiB;      // size of the pages backing the hash.
+    int evalCacheProbes; // static eval cache lookups ...
+    int evalCacheHits;   // ... and how many of them hit.
+    int lazyEvals;       // evals (not from the cache) that exited early ...
+    int fullEvals;       // ... and that did not.
+    HashStatsT hash;
     EngineStatsT();  // This struct can initialize itself.
     void Clear();
 };
@@ -53,12 +127,17 @@ struct EnginePvArgsT
 
 struct EngineSearchDoneArgsT
 {
-    EngineSearchDoneArgsT() : pv(0) {}
-    EngineSearchDoneArgsT(MoveT move, Eval eval, const SearchPv &pv) :
-        move(move), eval(eval), pv(pv) {}
+    EngineSearchDoneArgsT() : nodes(0), drawPly(0), pv({nullptr, 0}) {}
+    EngineSearchDoneArgsT(MoveT move, Eval eval, uint64 nodes, int drawPly,
+                          const PvRefT &pv) :
+        move(move), eval(eval), nodes(nodes), drawPly(drawPly), pv(pv) {}
     MoveT move;
     Eval eval;
-    SearchPv pv;
+    uint64 nodes; // size of the searched subtree (used for root move ordering)
+    int drawPly;  // see Thinker::ContextT::drawPly.
+    // Line found by the searcher.  This points into the searcher's PvTable,
+    //  so it must be copied out before the searcher is given another command.
+    PvRefT pv;
 };
 
 #endif // ENGINETYPES_H
@@ -0,0 +1,66 @@
+//--------------------------------------------------------------------------
+//            EvalCache.cpp - cache of static evaluations.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#include "EvalCache.h"
+
+// Returns: the biggest power of 2 entries that fits in 'sizeInBytes'.
+static size_t calcNumEntries(int64 sizeInBytes)
+{
+    size_t result = 1;
+
+    if (sizeInBytes < int64(sizeof(uint64)))
+        return 0;
+    while (int64(result * 2 * sizeof(uint64)) <= sizeInBytes)
+        result *= 2;
+    return result;
+}
+
+EvalCache::EvalCache() : numEntries(0)
+{
+    nextNumEntries = calcNumEntries(DefaultSize());
+}
+
+size_t EvalCache::DefaultSize()
+{
+    // Evals are small and this is shared by every thread, so this catches
+    //  most repeats for searches of a typical length.
+    return 8 * 1024 * 1024;
+}
+
+void EvalCache::SetDesiredSize(int64 sizeInBytes)
+{
+    nextNumEntries = calcNumEntries(sizeInBytes);
+}
+
+void EvalCache::Reset()
+{
+    if (nextNumEntries != numEntries)
+    {
+        // Free the old memory first (we do not need to preserve it).
+        entries = nullptr;
+        numEntries = nextNumEntries;
+        if (numEntries)
+            entries.reset(new std::atomic<uint64>[numEntries]);
+    }
+
+    // (An all-zero entry is a (wrong) hit for zobrists with a zero upper
+    //  half, but that is no likelier than any other false hit.)
+    for (size_t i = 0; i < numEntries; i++)
+        entries[i].store(0, std::memory_order_relaxed);
+}
+
+void EvalCache::Reset(int64 sizeInBytes)
+{
+    SetDesiredSize(sizeInBytes);
+    Reset();
+}
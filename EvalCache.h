@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------------
+//             EvalCache.h - cache of static evaluations.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include <atomic>
+#include <memory>
+
+#include "aTypes.h"
+
+// A small, lossy cache of static evaluations (see Evaluate()), shared by all
+//  searcher threads.  Unlike the transposition table, this needs no locking:
+//  each entry is a single 64-bit word (the upper half of the zobrist, and
+//  the eval), so a reader either sees a whole entry or misses.
+// Like TransTable, this does lazy initialization, and must be Reset() before
+//  it can actually be used (otherwise its effective size will be 0).
+class EvalCache
+{
+public:
+    EvalCache();
+
+    // Clears the cache.  Does not change its size, unless 'SetDesiredSize()'
+    //  has been called in the meantime.
+    void Reset();
+    // Clears the cache, and sets its size to (a bit under) 'sizeInBytes'.  0
+    //  disables the cache.
+    void Reset(int64 sizeInBytes);
+
+    // Sets desired size of the cache.  Does not take effect until the next
+    //  'Reset(void)' call.
+    void SetDesiredSize(int64 sizeInBytes);
+
+    // Returns the current size (in bytes) of the cache.
+    size_t Size() const;
+
+    // Returns the default size (in bytes) of the cache.
+    static size_t DefaultSize();
+
+    // Returns: true iff we found a cached eval for 'zobrist' (in which case it
+    //  is written to 'eval').
+    inline bool Probe(uint64 zobrist, int *eval) const;
+    inline void Store(uint64 zobrist, int eval);
+
+private:
+    std::unique_ptr<std::atomic<uint64>[]> entries;
+    size_t numEntries; // always a power of 2 (or 0)
+    size_t nextNumEntries; // takes effect on next reset
+};
+
+inline size_t EvalCache::Size() const
+{
+    return numEntries * sizeof(uint64);
+}
+
+inline bool EvalCache::Probe(uint64 zobrist, int *eval) const
+{
+    if (!numEntries)
+        return false;
+
+    // (The index comes from the low bits of the zobrist, so we check the
+    //  high ones.)
+    uint64 entry =
+        entries[zobrist & (numEntries - 1)].load(std::memory_order_relaxed);
+    if ((entry ^ zobrist) >> 32)
+        return false;
+    *eval = int32(uint32(entry));
+    return true;
+}
+
+inline void EvalCache::Store(uint64 zobrist, int eval)
+{
+    if (!numEntries)
+        return;
+
+    entries[zobrist & (numEntries - 1)].store(
+        (zobrist & ~uint64(0xffffffff)) | uint32(eval),
+        std::memory_order_relaxed);
+}
+
+#endif // EVALCACHE_H
@@ -0,0 +1,252 @@
+//--------------------------------------------------------------------------
+//           EvalParams.cpp - tunable evaluation weights.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#include <stdio.h>
+
+#include "EvalParams.h"
+#include "gPreCalc.h"
+
+// Default piece-square tables.  These are from White's point of view, and laid
+//  out like a diagram (8th rank first), so they are easy to read and tweak.
+// The values themselves are fairly conservative (we would rather under-
+//  than over-estimate positional factors when they are not backed up by any
+//  real knowledge).
+// Pieces whose value does not depend much on the game phase use the same
+//  table for the middlegame and the endgame.
+static const int kPawnTable[NUM_SQUARES] =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+// In the endgame, passers need to run (and the center matters less).
+static const int kPawnEgTable[NUM_SQUARES] =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     15,  15,  15,  15,  15,  15,  15,  15,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0
+};
+
+static const int kKnightTable[NUM_SQUARES] =
+{
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50
+};
+
+static const int kBishopTable[NUM_SQUARES] =
+{
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20
+};
+
+static const int kRookTable[NUM_SQUARES] =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0
+};
+
+static const int kQueenTable[NUM_SQUARES] =
+{
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+// The king should stay sheltered while there is material to attack it ...
+static const int kKingTable[NUM_SQUARES] =
+{
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20
+};
+
+// ... but should become active once there is not.  (See also endGameEval() in
+//  comp.cpp for pawnless endgames.)
+static const int kKingEgTable[NUM_SQUARES] =
+{
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50
+};
+
+// Default structure, mobility, and king safety scores, as {middlegame,
+//  endgame}.
+static const PhasedScoreT kMobility[int(PieceType::Queen) + 1] =
+{
+    {0, 0}, // Empty
+    {0, 0}, // King
+    {0, 0}, // Pawn
+    {4, 4}, // Knight
+    {4, 5}, // Bishop
+    {2, 4}, // Rook
+    {1, 2}  // Queen
+};
+static const int kKingAttackWeight[int(PieceType::Queen) + 1] =
+    {0, 0, 0, 2, 2, 3, 5};
+static const int kMaxKingDanger = 500;
+
+static const PhasedScoreT kDoubled  = {-10, -20};
+static const PhasedScoreT kIsolated = {-10, -15};
+static const PhasedScoreT kBackward = { -8, -10};
+// (The piece-square tables already reward advancing pawns in the endgame; this
+//  is on top of that.)
+static const PhasedScoreT kPassed[8] =
+{
+    {0, 0}, {0, 5}, {5, 10}, {10, 20}, {15, 35}, {25, 55}, {40, 80}, {0, 0}
+};
+static const int kShieldRank2 = 10;
+static const int kShieldRank3 = 5;
+static const int kShieldMissing = -10;
+
+static const char *const kTypeNames[int(PieceType::Queen) + 1] =
+    {"", "king", "pawn", "knight", "bishop", "rook", "queen"};
+
+static EvalParamsT defaultParams()
+{
+    EvalParamsT result;
+    // Pieces whose value does not depend much on the game phase start out
+    //  with the same table for the middlegame and the endgame.
+    const int *mgTables[int(PieceType::Queen) + 1] =
+        {nullptr, kKingTable, kPawnTable, kKnightTable, kBishopTable,
+         kRookTable, kQueenTable};
+    const int *egTables[int(PieceType::Queen) + 1] =
+        {nullptr, kKingEgTable, kPawnEgTable, kKnightTable, kBishopTable,
+         kRookTable, kQueenTable};
+
+    for (int type = 0; type <= int(PieceType::Queen); type++)
+    {
+        for (int idx = 0; idx < NUM_SQUARES; idx++)
+        {
+            result.pst[type] [idx] = type == int(PieceType::Empty) ?
+                PhasedScoreT{0, 0} :
+                PhasedScoreT{mgTables[type] [idx], egTables[type] [idx]};
+        }
+        result.mobility[type] = kMobility[type];
+        result.kingAttackWeight[type] = kKingAttackWeight[type];
+    }
+    result.maxKingDanger = kMaxKingDanger;
+
+    result.doubled = kDoubled;
+    result.isolated = kIsolated;
+    result.backward = kBackward;
+    for (int rank = 0; rank < 8; rank++)
+        result.passed[rank] = kPassed[rank];
+    result.shieldRank2 = kShieldRank2;
+    result.shieldRank3 = kShieldRank3;
+    result.shieldMissing = kShieldMissing;
+    return result;
+}
+
+EvalParamsT gEvalParams = defaultParams();
+
+static void addPhased(std::vector<EvalParamT> &list, const std::string &name,
+                      PhasedScoreT &score)
+{
+    list.push_back(EvalParamT{name + ".mg", &score.mg});
+    list.push_back(EvalParamT{name + ".eg", &score.eg});
+}
+
+std::vector<EvalParamT> EvalParamsList()
+{
+    std::vector<EvalParamT> result;
+    EvalParamsT &p = gEvalParams; // shorthand
+    char square[3];
+
+    for (int type = int(PieceType::King);
+         type <= int(PieceType::Queen);
+         type++)
+    {
+        for (int idx = 0; idx < NUM_SQUARES; idx++)
+        {
+            int rank = 7 - idx / 8; // (diagram index, remember)
+            // (Pawns never stand on the 1st or 8th rank.)
+            if (type == int(PieceType::Pawn) && (rank == 0 || rank == 7))
+                continue;
+            snprintf(square, sizeof(square), "%c%c",
+                     'a' + idx % 8, '1' + rank);
+            addPhased(result, std::string("pst.") + kTypeNames[type] + "." +
+                      square, p.pst[type] [idx]);
+        }
+    }
+    for (int type = int(PieceType::Knight);
+         type <= int(PieceType::Queen);
+         type++)
+    {
+        addPhased(result, std::string("mobility.") + kTypeNames[type],
+                  p.mobility[type]);
+        result.push_back(EvalParamT{std::string("kingAttackWeight.") +
+                                    kTypeNames[type],
+                                    &p.kingAttackWeight[type]});
+    }
+    result.push_back(EvalParamT{"maxKingDanger", &p.maxKingDanger});
+
+    addPhased(result, "doubled", p.doubled);
+    addPhased(result, "isolated", p.isolated);
+    addPhased(result, "backward", p.backward);
+    for (int rank = 1; rank < 7; rank++)
+        addPhased(result, "passed.r" + std::to_string(rank + 1),
+                  p.passed[rank]);
+    result.push_back(EvalParamT{"shieldRank2", &p.shieldRank2});
+    result.push_back(EvalParamT{"shieldRank3", &p.shieldRank3});
+    result.push_back(EvalParamT{"shieldMissing", &p.shieldMissing});
+    return result;
+}
+
+void EvalParamsChanged()
+{
+    PstRefresh();
+}
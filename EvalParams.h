@@ -0,0 +1,72 @@
+//--------------------------------------------------------------------------
+//           EvalParams.h - tunable evaluation weights.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#ifndef EVALPARAMS_H
+#define EVALPARAMS_H
+
+#include <string>
+#include <vector>
+
+#include "Piece.h"
+#include "Pst.h"
+#include "ref.h"
+
+// Weights used by the hand-written evaluation (Pst.cpp, Pawns.cpp, and
+//  Evaluate.cpp all read these instead of keeping their own constants).  They
+//  are only meant to be changed by tools like the tuner; see
+//  EvalParamsChanged().
+struct EvalParamsT
+{
+    // Piece-square tables, indexed by piece type and then by diagram index
+    //  (a8 == 0, h1 == 63) from White's point of view.  Black's values are
+    //  mirrored.
+    PhasedScoreT pst[int(PieceType::Queen) + 1] [NUM_SQUARES];
+
+    // Mobility score per attacked square, by piece type.
+    PhasedScoreT mobility[int(PieceType::Queen) + 1];
+    // How dangerous an attacker of the enemy king zone is, by piece type.
+    int kingAttackWeight[int(PieceType::Queen) + 1];
+    // Cap on the king danger penalty (before game phase blending).
+    int maxKingDanger;
+
+    // Pawn structure scores.  'doubled' is per extra pawn on a file.
+    PhasedScoreT doubled;
+    PhasedScoreT isolated;
+    PhasedScoreT backward;
+    // Passed pawn bonus, indexed by relative rank.
+    PhasedScoreT passed[8];
+    // Shield scores (middlegame only), per file next to the king.
+    int shieldRank2; // (relative rank)
+    int shieldRank3;
+    int shieldMissing;
+};
+
+extern EvalParamsT gEvalParams;
+
+// A single weight in gEvalParams, by name (like "passed.r5.eg").
+struct EvalParamT
+{
+    std::string name;
+    int *value;
+};
+
+// Returns: every tunable weight in gEvalParams, in a fixed order.
+std::vector<EvalParamT> EvalParamsList();
+
+// Must be called after changing gEvalParams (and before the next search), so
+//  that anything derived from the weights catches up.  Boards set up before
+//  the call keep their old piece-square sums, and each thread's pawn hash (see
+//  PawnClearCache()) must be cleared by that thread.
+void EvalParamsChanged();
+
+#endif // EVALPARAMS_H
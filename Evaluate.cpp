@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------
+//           Evaluate.cpp - static (positional) evaluation.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#include "Endgame.h"
+#include "EvalParams.h"
+#include "Evaluate.h"
+#include "Nnue.h"
+#include "Pawns.h"
+#include "Pst.h"
+
+// Returns: the mobility and king safety score of 'player'.
+static PhasedScoreT attackScore(const AttackInfoT &info, uint8 player)
+{
+    const EvalParamsT &params = gEvalParams; // shorthand
+    PhasedScoreT result = {0, 0};
+    int attackers = 0, weight = 0;
+
+    for (int type = int(PieceType::Knight);
+         type <= int(PieceType::Queen);
+         type++)
+    {
+        int mobility = info.mobility[player] [type];
+        result += PhasedScoreT{params.mobility[type].mg * mobility,
+                               params.mobility[type].eg * mobility};
+
+        // (Score the danger to *our* king.)
+        int numAttackers = info.kingZoneAttackers[player ^ 1] [type];
+        attackers += numAttackers;
+        weight += numAttackers * params.kingAttackWeight[type];
+    }
+
+    // A lone attacker is not much of a threat, but danger rises quickly with
+    //  each additional one.  This matters only in the middlegame.
+    if (attackers >= 2)
+        result.mg -= MIN(weight * weight * 2, params.maxKingDanger);
+    return result;
+}
+
+// The hand-written evaluation (see EvaluateLazy()).
+static int classicalEval(const Board &board, const MaterialInfoT &material,
+                         int alpha, int beta, int margin, bool *lazy)
+{
+    uint8 turn = board.Turn();
+    int result = board.RelativeMaterialStrength() + board.PositionalScore();
+    PhasedScoreT score = {0, 0};
+
+    // Pawn structure, mobility, and king safety rarely swing the eval by more
+    //  than 'margin', so do not bother with them when we would be (far) out
+    //  of the window anyway.
+    if (margin != 0 && (result <= alpha - margin || result >= beta + margin))
+    {
+        *lazy = true;
+        return result;
+    }
+
+    if (material.HasPawns())
+    {
+        const PawnInfoT &pawns = PawnLookup(board);
+        score +=
+            pawns.Score(turn,
+                        board.PieceCoords(Piece(turn, PieceType::King))[0]) -
+            pawns.Score(turn ^ 1,
+                        board.PieceCoords(Piece(turn ^ 1,
+                                                PieceType::King))[0]);
+    }
+
+    AttackInfoT attacks;
+    board.GenerateAttacks(attacks);
+    score += attackScore(attacks, turn) - attackScore(attacks, turn ^ 1);
+
+    return result + score.Blend(material.phase);
+}
+
+int Evaluate(const Board &board, const MaterialInfoT &material)
+{
+    bool lazy;
+    return EvaluateLazy(board, material, Eval::Loss, Eval::Win, 0, &lazy);
+}
+
+int EvaluateLazy(const Board &board, const MaterialInfoT &material,
+                 int alpha, int beta, int margin, bool *lazy)
+{
+    *lazy = false;
+    if (EndgameHasEvaluator(material.endgame))
+        return EndgameEvaluate(board, material);
+    if (NnueNetId() != 0)
+    {
+        int result = NnueEvaluate(board);
+        return EndgameHasScale(material.endgame) ?
+            EndgameScale(result, board, material) : result;
+    }
+    if (EndgameHasScale(material.endgame))
+    {
+        // (A partial score could be scaled back into the window, so always do
+        //  the full evaluation here.)
+        return EndgameScale(classicalEval(board, material, alpha, beta, 0,
+                                          lazy),
+                            board, material);
+    }
+    return classicalEval(board, material, alpha, beta, margin, lazy);
+}
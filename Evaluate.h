@@ -0,0 +1,35 @@
+//--------------------------------------------------------------------------
+//            Evaluate.h - static (positional) evaluation.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include "Board.h"
+#include "Material.h"
+
+// Returns: the static evaluation of 'board', from the point of view of the
+//  side to move.  'material' must describe the material on 'board' (it is
+//  passed in since the search has usually already looked it up).
+// If a network is loaded (see Nnue.h), it replaces the hand-written terms.
+//  Either is overridden (or scaled) in recognized endgames (see Endgame.h).
+int Evaluate(const Board &board, const MaterialInfoT &material);
+
+// Like Evaluate(), but the caller only cares about evals inside
+//  ['alpha', 'beta'].  If the cheap (material and piece-square) part of the
+//  hand-written evaluation is already more than 'margin' outside that window,
+//  the expensive terms are skipped, that partial score is returned, and
+//  '*lazy' is set.  A 'margin' of 0 disables this.
+int EvaluateLazy(const Board &board, const MaterialInfoT &material,
+                 int alpha, int beta, int margin, bool *lazy);
+
+#endif // EVALUATE_H
@@ -0,0 +1,200 @@
+//--------------------------------------------------------------------------
+//         Material.cpp - material signature-related functionality.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#include <assert.h>
+#include <stdlib.h> // abs(3)
+#include <vector>
+
+#include "Endgame.h"
+#include "Eval.h"
+#include "Material.h"
+
+using arctic::File;
+using arctic::Rank;
+
+// Fields are laid out as ((pieceType - Pawn) * NUM_PLAYERS + player), followed
+//  by the dark-squared bishops of each player.
+static const int kDarkBishopField =
+    (int(PieceType::Queen) - int(PieceType::Pawn) + 1) * NUM_PLAYERS;
+static const int kNumFields = kDarkBishopField + NUM_PLAYERS;
+static_assert(kNumFields * kMaterialKeyFieldBits <= 64,
+              "material key does not fit in 64 bits");
+
+// Must be a power of 2.  There are normally only a handful of distinct
+//  material signatures in any given search, so this can be small.
+static const int kNumEntries = 1024;
+
+namespace // start unnamed namespace
+{
+
+class MaterialTable
+{
+public:
+    MaterialTable();
+    inline const MaterialInfoT &Lookup(uint64 key);
+private:
+    std::vector<MaterialInfoT> entries;
+    void calc(MaterialInfoT &info, uint64 key) const;
+};
+
+} // end unnamed namespace
+
+static thread_local MaterialTable gMaterialTable;
+
+static inline int fieldCount(uint64 key, int field)
+{
+    return (key >> (field * kMaterialKeyFieldBits)) & kMaterialKeyFieldMask;
+}
+
+static inline int pieceCount(uint64 key, uint8 player, PieceType type)
+{
+    int field = (int(type) - int(PieceType::Pawn)) * NUM_PLAYERS + player;
+    return fieldCount(key, field) +
+        (type == PieceType::Bishop ?
+         fieldCount(key, kDarkBishopField + player) : 0);
+}
+
+int MaterialKeyField(Piece piece, cell_t coord)
+{
+    assert(!piece.IsEmpty() && !piece.IsKing());
+    return
+        // (a1 is a dark square)
+        piece.IsBishop() && !((Rank(coord) + File(coord)) & 1) ?
+        kDarkBishopField + piece.Player() :
+        (int(piece.Type()) - int(PieceType::Pawn)) * NUM_PLAYERS +
+        piece.Player();
+}
+
+uint64 MaterialKeyInc(Piece piece, cell_t coord)
+{
+    return piece.IsEmpty() || piece.IsKing() ? 0 :
+        uint64(1) << (MaterialKeyField(piece, coord) * kMaterialKeyFieldBits);
+}
+
+MaterialTable::MaterialTable() : entries(kNumEntries)
+{
+    // Make sure every entry starts out as a miss.  (A key of 0 is valid (bare
+    //  kings), so we cannot rely on zero-initialization.)
+    for (int i = 0; i < kNumEntries; i++)
+        entries[i].key = ~uint64(0);
+}
+
+inline const MaterialInfoT &MaterialTable::Lookup(uint64 key)
+{
+    // (The key is mostly low-order bits, so mix them up a bit.)
+    MaterialInfoT &info =
+        entries[((key * 0x9e3779b97f4a7c15ULL) >> 32) & (kNumEntries - 1)];
+
+    if (info.key != key)
+        calc(info, key);
+    return info;
+}
+
+void MaterialTable::calc(MaterialInfoT &info, uint64 key) const
+{
+    static const PieceType kNonPawnTypes[] =
+        {PieceType::Queen, PieceType::Rook, PieceType::Bishop,
+         PieceType::Knight};
+    int nonPawnMaterial = 0, sideMaterial[NUM_PLAYERS] = {0, 0};
+    int maxPhaseMaterial = 0;
+    int minors[NUM_PLAYERS], majors[NUM_PLAYERS], pawns[NUM_PLAYERS];
+
+    info.key = key;
+    info.flags = 0;
+
+    for (uint8 player = 0; player < NUM_PLAYERS; player++)
+    {
+        pawns[player] = pieceCount(key, player, PieceType::Pawn);
+        minors[player] = pieceCount(key, player, PieceType::Knight) +
+            pieceCount(key, player, PieceType::Bishop);
+        majors[player] = pieceCount(key, player, PieceType::Rook) +
+            pieceCount(key, player, PieceType::Queen);
+
+        // Find the most valuable piece this player could lose.
+        info.maxCapture[player] = pawns[player] ? Eval::Pawn : 0;
+        for (PieceType type : kNonPawnTypes)
+        {
+            if (pieceCount(key, player, type))
+            {
+                info.maxCapture[player] = Piece(player, type).Worth();
+                break;
+            }
+        }
+
+        for (PieceType type : kNonPawnTypes)
+        {
+            sideMaterial[player] +=
+                pieceCount(key, player, type) * Piece(player, type).Worth();
+        }
+        nonPawnMaterial += sideMaterial[player];
+        // (Normal starting material.)
+        maxPhaseMaterial +=
+            Piece(player, PieceType::Queen).Worth() +
+            2 * (Piece(player, PieceType::Rook).Worth() +
+                 Piece(player, PieceType::Bishop).Worth() +
+                 Piece(player, PieceType::Knight).Worth());
+
+        if (!pawns[player])
+            info.flags |= MaterialInfoT::kNoPawns << player;
+        if (!pawns[player] && !minors[player] && !majors[player])
+            info.flags |= MaterialInfoT::kBareKing << player;
+    }
+
+    info.phase = maxPhaseMaterial <= 0 ? 0 :
+        MIN(nonPawnMaterial, maxPhaseMaterial) * MaterialInfoT::kMaxPhase /
+        maxPhaseMaterial;
+
+    bool noPawnsOrMajors =
+        !pawns[0] && !pawns[1] && !majors[0] && !majors[1];
+    int lightBishops[NUM_PLAYERS], darkBishops[NUM_PLAYERS];
+    for (uint8 player = 0; player < NUM_PLAYERS; player++)
+    {
+        darkBishops[player] = fieldCount(key, kDarkBishopField + player);
+        lightBishops[player] =
+            pieceCount(key, player, PieceType::Bishop) - darkBishops[player];
+    }
+
+    if (noPawnsOrMajors &&
+        // K vs k, or (KN or KB) vs k
+        (minors[0] + minors[1] <= 1 ||
+         // KB vs kb, bishops on same color
+         (minors[0] == 1 && minors[1] == 1 &&
+          ((lightBishops[0] && lightBishops[1]) ||
+           (darkBishops[0] && darkBishops[1])))))
+    {
+        info.flags |= MaterialInfoT::kInsufficientMaterial;
+    }
+
+    info.endgame = EndgameLookup(key, &info.strongSide);
+    if (info.endgame != EndgameT::None)
+        return;
+
+    if (!majors[0] && !majors[1] && minors[0] == 1 && minors[1] == 1 &&
+        ((lightBishops[0] && darkBishops[1]) ||
+         (darkBishops[0] && lightBishops[1])))
+    {
+        info.endgame = EndgameT::OppositeBishops;
+    }
+    else if (!pawns[0] && !pawns[1])
+    {
+        // (Bare kings are caught by kInsufficientMaterial.)
+        info.endgame =
+            abs(sideMaterial[0] - sideMaterial[1]) < Eval::Rook ?
+            EndgameT::DrawishPawnless : EndgameT::MopUp;
+    }
+}
+
+const MaterialInfoT &MaterialLookup(uint64 key)
+{
+    return gMaterialTable.Lookup(key);
+}
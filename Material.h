@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------
+//          Material.h - material signature-related functionality.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "aTypes.h"
+#include "Piece.h"
+#include "ref.h"
+
+// A material key (see Board::MaterialKey()) packs a count of each kind of
+//  non-king piece into its own bitfield, so it can be updated incrementally by
+//  simply adding or subtracting MaterialKeyInc().  Bishops on dark squares are
+//  counted separately from bishops on light squares, so bishop square colors
+//  (which matter for some draws) can also be recovered from the key.
+// A field can hold a count of up to 31, which any sane position satisfies.
+const int kMaterialKeyFieldBits = 5;
+const int kMaterialKeyFieldMask = (1 << kMaterialKeyFieldBits) - 1;
+
+// Returns: the material key field that counts 'piece' (when it sits on
+//  'coord').  'piece' must not be a king (or empty).
+int MaterialKeyField(Piece piece, cell_t coord);
+// Returns: how much adding 'piece' at 'coord' changes a material key.  (This
+//  is 0 for kings and empty squares.)  Used to fill in gPreCalc.materialKey.
+uint64 MaterialKeyInc(Piece piece, cell_t coord);
+
+// Endgames that get a specialized evaluation (see Endgame.h).  Except for
+//  MopUp (which the search handles itself), these either replace the normal
+//  evaluation, or scale it.
+enum class EndgameT : uint8
+{
+    None,
+    MopUp, // No pawns on the board; drive the weaker king to the edge.
+
+    // Evaluators.
+    KBNK,     // drive the king to a corner the bishop controls.
+    KQKR,
+    KRKMinor, // KR vs KB or KN; usually a draw.
+    KPK,      // rule of the square, and a few other basics.
+
+    // Scaling functions.
+    OppositeBishops, // (just bishops and pawns left)
+    DrawishPawnless  // not enough advantage to win without pawns.
+};
+
+// Everything that can be derived from just the material on the board.
+struct MaterialInfoT
+{
+    uint64 key;      // material key this information is valid for.
+    int16 phase;     // kMaxPhase (all non-pawn material still on the board)
+                     //  down to 0 (bare kings and pawns).
+    uint8 flags;     // see below.
+    EndgameT endgame;
+    uint8 strongSide; // side with the advantage (for evaluator endgames).
+    // Worth of the most valuable non-king piece each player could lose (0 if
+    //  the player has a bare king).
+    int16 maxCapture[NUM_PLAYERS];
+
+    static const int kMaxPhase = 256;
+
+    inline bool IsDrawInsufficientMaterial() const;
+    inline bool HasPawns(uint8 player) const;
+    inline bool HasPawns() const; // ... for either side?
+    inline bool IsBareKing(uint8 player) const;
+
+    // (private flags)
+    static const uint8 kInsufficientMaterial = 0x1;
+    static const uint8 kNoPawns = 0x2;   // (shifted left by player)
+    static const uint8 kBareKing = 0x8;  // (shifted left by player)
+};
+
+// Returns information about the material described by 'key'.  This is cached
+//  per-thread, so it is usually a simple table lookup.
+const MaterialInfoT &MaterialLookup(uint64 key);
+
+inline bool MaterialInfoT::IsDrawInsufficientMaterial() const
+{
+    return flags & kInsufficientMaterial;
+}
+
+inline bool MaterialInfoT::HasPawns(uint8 player) const
+{
+    return !(flags & (kNoPawns << player));
+}
+
+inline bool MaterialInfoT::HasPawns() const
+{
+    const uint8 noPawns = kNoPawns | (kNoPawns << 1);
+    return (flags & noPawns) != noPawns;
+}
+
+inline bool MaterialInfoT::IsBareKing(uint8 player) const
+{
+    return flags & (kBareKing << player);
+}
+
+#endif // MATERIAL_H
@@ -11,6 +11,8 @@
 // obtain one at https://mozilla.org/MPL/2.0/.
 //--------------------------------------------------------------------------
 
+#include <algorithm> // std::stable_sort()
+
 #include "Board.h"
 #include "HistoryWindow.h"
 #include "MoveList.h"
@@ -124,6 +126,20 @@ void MoveList::useAsFirstMove(MoveT firstMove)
     *startMove = myMove; // Now replace the first move.
 }
 
+void MoveList::PreferMove(MoveT move)
+{
+    if (move == MoveNone)
+        return;
+
+    MoveT *foundMove = SearchSrcDstPromote(move);
+
+    if (foundMove == nullptr || foundMove < &moves[insrt])
+        return; // Missing, or already preferred.
+
+    std::swap(*foundMove, moves[insrt]);
+    insrt++;
+}
+
 const MoveT *MoveList::SearchSrcDst(MoveT move) const
 {
     auto end = moves.end();
@@ -256,3 +272,61 @@ void MoveList::Log(LogLevelT level) const
 
     LogPrint(level, "}\n");
 }
+
+RootMoveList &RootMoveList::operator=(const MoveList &other)
+{
+    MoveList::operator=(other);
+    ClearResults();
+    return *this;
+}
+
+void RootMoveList::ClearResults()
+{
+    results.assign(NumMoves(), ResultT({0, Eval(Eval::Loss, Eval::Win)}));
+}
+
+void RootMoveList::SetResult(MoveT move, uint64 nodes, Eval eval)
+{
+    const MoveT *foundMove = Search(move);
+
+    if (foundMove == nullptr)
+        return;
+    if (int(results.size()) != NumMoves())
+        ClearResults();
+
+    ResultT &result = results[foundMove - &moves[0]];
+    result.nodes = nodes;
+    result.eval = eval;
+}
+
+void RootMoveList::SortBySubtreeSize(MoveT firstMove)
+{
+    int numMoves = NumMoves();
+    std::vector<int> order(numMoves);
+    const MoveT *foundMove = SearchSrcDstPromote(firstMove);
+    int firstIdx = foundMove == nullptr ? -1 : foundMove - &moves[0];
+
+    if (int(results.size()) != numMoves)
+        ClearResults();
+
+    for (int i = 0; i < numMoves; i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [this, firstIdx](int a, int b)
+                     {
+                         return a == firstIdx ? b != firstIdx :
+                             b == firstIdx ? false :
+                             results[a].nodes > results[b].nodes;
+                     });
+
+    std::vector<MoveT> sortedMoves(numMoves);
+    std::vector<ResultT> sortedResults(numMoves);
+    for (int i = 0; i < numMoves; i++)
+    {
+        sortedMoves[i] = moves[order[i]];
+        sortedResults[i] = results[order[i]];
+    }
+    moves.swap(sortedMoves);
+    results.swap(sortedResults);
+    insrt = numMoves;
+}
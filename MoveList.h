@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "aTypes.h"
+#include "Eval.h"
 #include "log.h"
 #include "move.h"
 
@@ -49,6 +50,12 @@ public:
     //  otherwise no-op).
     void UseAsFirstMove(MoveT move);
 
+    // Make 'move' the last 'preferred' move (if it is currently a
+    //  non-preferred move in our movelist, otherwise no-op).  Used for killer
+    //  moves, which should be tried after captures etc. but before other
+    //  quiet moves.
+    void PreferMove(MoveT move);
+
     // If there is a move in the movelist that matches the same src and dst,
     //  return a pointer to it, otherwise NULL.  (I'd return an index, but
     //  indexing off -1 is worse than dereferencing NULL).
@@ -97,6 +104,42 @@ private:
     void useAsFirstMove(MoveT move);
 };
 
+// A MoveList that also remembers how large each move's subtree was (and what
+//  it scored) during the last search iteration.  Used at the root, where the
+//  extra bookkeeping is cheap and good move ordering pays off the most.
+class RootMoveList : public MoveList
+{
+public:
+    // Copies the moves of 'other'; any recorded results are discarded.
+    RootMoveList &operator=(const MoveList &other);
+
+    // Forget any results recorded by SetResult().
+    void ClearResults();
+
+    // Record the result of searching 'move' (no-op if 'move' is not in the
+    //  list).
+    void SetResult(MoveT move, uint64 nodes, Eval eval);
+
+    // Results for the move at index 'idx'.  If no result was recorded,
+    //  returns 0 nodes and an Eval of {Eval::Loss, Eval::Win}.
+    inline uint64 Nodes(int idx) const;
+    inline Eval Evals(int idx) const;
+
+    // Sort the list so that 'firstMove' (if present) comes first, and the
+    //  remaining moves follow by decreasing subtree size (ties keep their
+    //  current order).  Afterwards, every move counts as 'preferred', since
+    //  the capture/check/history ordering no longer applies.
+    void SortBySubtreeSize(MoveT firstMove);
+
+private:
+    struct ResultT
+    {
+        uint64 nodes;
+        Eval eval;
+    };
+    std::vector<ResultT> results; // parallel to 'moves' (when not empty)
+};
+
 inline bool MoveList::IsPreferredMove(int idx) const
 {
     return idx < insrt;
@@ -124,4 +167,15 @@ inline void MoveList::DeleteAllMoves()
     insrt = 0;
 }
 
+inline uint64 RootMoveList::Nodes(int idx) const
+{
+    return idx < int(results.size()) ? results[idx].nodes : 0;
+}
+
+inline Eval RootMoveList::Evals(int idx) const
+{
+    return idx < int(results.size()) ? results[idx].eval :
+        Eval(Eval::Loss, Eval::Win);
+}
+
 #endif // MOVELIST_H
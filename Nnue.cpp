@@ -0,0 +1,455 @@
+//--------------------------------------------------------------------------
+//            Nnue.cpp - efficiently updatable neural net evaluation.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+
+// We pick the kernels at compile time (see ENABLE_NATIVE_ARCH in
+//  CMakeLists.txt), so a default build runs on any x86-64 (or non-x86) box.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+#include "Board.h"
+#include "log.h"
+#include "Nnue.h"
+
+// Network file format (all values little-endian):
+//  "ARCTNNUE" magic, then uint32 version, kNnueFeatures, kNnueL1, kNnueL2,
+//  and kNnueL3 (which must match ours);
+//  feature transformer: int16 biases[kNnueL1],
+//                       int16 weights[kNnueFeatures] [kNnueL1];
+//  hidden layer 1:      int32 biases[kNnueL2],
+//                       int8 weights[kNnueL2] [2 * kNnueL1];
+//  hidden layer 2:      int32 biases[kNnueL3], int8 weights[kNnueL3] [kNnueL2];
+//  output layer:        int32 bias, int8 weights[kNnueL3].
+static const char kMagic[] = "ARCTNNUE";
+static const uint32 kVersion = 1;
+
+// Hidden layer outputs are scaled down by this many bits before clipping.
+static const int kWeightShift = 6;
+// The output layer produces (centipawns * kOutputScale).
+static const int kOutputScale = 16;
+
+namespace // start unnamed namespace
+{
+
+struct NetworkT
+{
+    int16 ftBiases[kNnueL1];
+    std::vector<int16> ftWeights; // kNnueFeatures rows of kNnueL1
+    int32 l1Biases[kNnueL2];
+    int8 l1Weights[kNnueL2] [2 * kNnueL1];
+    int32 l2Biases[kNnueL3];
+    int8 l2Weights[kNnueL3] [kNnueL2];
+    int32 outBias;
+    int8 outWeights[kNnueL3];
+};
+
+// Reads little-endian values from a file, remembering if anything failed.
+class NetReader
+{
+public:
+    NetReader(FILE *file) : file(file), ok(true) {}
+    void Read(int8 *values, int count);
+    void Read(int16 *values, int count);
+    void Read(int32 *values, int count);
+    void Read(uint32 *values, int count);
+    bool AtEof();
+    bool Ok() const { return ok; }
+private:
+    FILE *file;
+    bool ok;
+    std::vector<uint8> buf;
+    const uint8 *readBytes(int count);
+};
+
+} // end unnamed namespace
+
+uint32 gNnueNetId = 0;
+
+static std::unique_ptr<NetworkT> gNet;
+static uint32 gLastNetId = 0;
+
+const uint8 *NetReader::readBytes(int count)
+{
+    buf.resize(count);
+    if (ok && fread(buf.data(), 1, count, file) != size_t(count))
+        ok = false;
+    return buf.data();
+}
+
+void NetReader::Read(int8 *values, int count)
+{
+    const uint8 *bytes = readBytes(count);
+    for (int i = 0; i < count; i++)
+        values[i] = int8(bytes[i]);
+}
+
+void NetReader::Read(int16 *values, int count)
+{
+    const uint8 *bytes = readBytes(count * 2);
+    for (int i = 0; i < count; i++)
+        values[i] = int16(bytes[i * 2] | (bytes[i * 2 + 1] << 8));
+}
+
+void NetReader::Read(uint32 *values, int count)
+{
+    const uint8 *bytes = readBytes(count * 4);
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = uint32(bytes[i * 4]) | (uint32(bytes[i * 4 + 1]) << 8) |
+            (uint32(bytes[i * 4 + 2]) << 16) | (uint32(bytes[i * 4 + 3]) << 24);
+    }
+}
+
+void NetReader::Read(int32 *values, int count)
+{
+    Read(reinterpret_cast<uint32 *>(values), count);
+}
+
+bool NetReader::AtEof()
+{
+    return getc(file) == EOF;
+}
+
+static std::unique_ptr<NetworkT> readNetwork(FILE *file)
+{
+    std::unique_ptr<NetworkT> net(new NetworkT);
+    NetReader reader(file);
+    char magic[sizeof(kMagic) - 1];
+    uint32 header[5];
+    const uint32 expected[5] =
+        {kVersion, kNnueFeatures, kNnueL1, kNnueL2, kNnueL3};
+
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, kMagic, sizeof(magic)) != 0)
+    {
+        LOG_NORMAL("%s: bad magic\n", __func__);
+        return nullptr;
+    }
+    reader.Read(header, 5);
+    if (!reader.Ok() || memcmp(header, expected, sizeof(header)) != 0)
+    {
+        LOG_NORMAL("%s: unsupported version or network layout\n", __func__);
+        return nullptr;
+    }
+
+    net->ftWeights.resize(kNnueFeatures * kNnueL1);
+    reader.Read(net->ftBiases, kNnueL1);
+    reader.Read(net->ftWeights.data(), kNnueFeatures * kNnueL1);
+    reader.Read(net->l1Biases, kNnueL2);
+    reader.Read(&net->l1Weights[0] [0], kNnueL2 * 2 * kNnueL1);
+    reader.Read(net->l2Biases, kNnueL3);
+    reader.Read(&net->l2Weights[0] [0], kNnueL3 * kNnueL2);
+    reader.Read(&net->outBias, 1);
+    reader.Read(net->outWeights, kNnueL3);
+    if (!reader.Ok() || !reader.AtEof())
+    {
+        LOG_NORMAL("%s: truncated (or oversized) network\n", __func__);
+        return nullptr;
+    }
+    return net;
+}
+
+bool NnueLoad(const std::string &fileName)
+{
+    gNet = nullptr;
+    gNnueNetId = 0;
+    if (fileName.empty())
+        return true;
+
+    FILE *file = fopen(fileName.c_str(), "rb");
+    if (file == nullptr)
+    {
+        LOG_NORMAL("%s: could not open %s\n", __func__, fileName.c_str());
+        return false;
+    }
+    gNet = readNetwork(file);
+    fclose(file);
+    if (gNet == nullptr)
+        return false;
+
+    gNnueNetId = ++gLastNetId;
+    LOG_NORMAL("%s: loaded %s\n", __func__, fileName.c_str());
+    return true;
+}
+
+// Returns: the index of feature ('piece' on 'coord') from 'perspective's point
+//  of view, when its king sits on 'kingCoord'.
+static inline int featureIndex(uint8 perspective, cell_t kingCoord,
+                               Piece piece, cell_t coord)
+{
+    int flip = perspective == 0 ? 0 : 56;
+    int pieceIdx = (int(piece.Type()) - int(PieceType::Pawn)) * 2 +
+        (piece.Player() != perspective);
+    return ((kingCoord ^ flip) * 10 + pieceIdx) * NUM_SQUARES + (coord ^ flip);
+}
+
+// --- Kernels.  Each has a scalar fallback for builds without SIMD support.
+
+// acc += row (kNnueL1 values)
+static inline void addRow(int16 *acc, const int16 *row)
+{
+#if defined(__AVX2__)
+    for (int i = 0; i < kNnueL1; i += 16)
+    {
+        __m256i *p = reinterpret_cast<__m256i *>(acc + i);
+        _mm256_storeu_si256(
+            p, _mm256_add_epi16(_mm256_loadu_si256(p),
+                                _mm256_loadu_si256(
+                                    reinterpret_cast<const __m256i *>(
+                                        row + i))));
+    }
+#elif defined(__SSE4_1__)
+    for (int i = 0; i < kNnueL1; i += 8)
+    {
+        __m128i *p = reinterpret_cast<__m128i *>(acc + i);
+        _mm_storeu_si128(
+            p, _mm_add_epi16(_mm_loadu_si128(p),
+                             _mm_loadu_si128(
+                                 reinterpret_cast<const __m128i *>(row + i))));
+    }
+#else
+    for (int i = 0; i < kNnueL1; i++)
+        acc[i] += row[i];
+#endif
+}
+
+// acc -= row (kNnueL1 values)
+static inline void subRow(int16 *acc, const int16 *row)
+{
+#if defined(__AVX2__)
+    for (int i = 0; i < kNnueL1; i += 16)
+    {
+        __m256i *p = reinterpret_cast<__m256i *>(acc + i);
+        _mm256_storeu_si256(
+            p, _mm256_sub_epi16(_mm256_loadu_si256(p),
+                                _mm256_loadu_si256(
+                                    reinterpret_cast<const __m256i *>(
+                                        row + i))));
+    }
+#elif defined(__SSE4_1__)
+    for (int i = 0; i < kNnueL1; i += 8)
+    {
+        __m128i *p = reinterpret_cast<__m128i *>(acc + i);
+        _mm_storeu_si128(
+            p, _mm_sub_epi16(_mm_loadu_si128(p),
+                             _mm_loadu_si128(
+                                 reinterpret_cast<const __m128i *>(row + i))));
+    }
+#else
+    for (int i = 0; i < kNnueL1; i++)
+        acc[i] -= row[i];
+#endif
+}
+
+// output[i] = clamp(input[i], 0, 127), for kNnueL1 values.
+static inline void clipAccumulator(uint8 *output, const int16 *input)
+{
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < kNnueL1; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(input + i));
+        __m256i b = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(input + i + 16));
+        // (packs works within 128-bit lanes, so we must put the quadwords
+        //  back in order afterwards.)
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b),
+                                                  0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i),
+                            _mm256_max_epi8(packed, zero));
+    }
+#elif defined(__SSE4_1__)
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < kNnueL1; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(input + i));
+        __m128i b = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(input + i + 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i),
+                         _mm_max_epi8(_mm_packs_epi16(a, b), zero));
+    }
+#else
+    for (int i = 0; i < kNnueL1; i++)
+        output[i] = MAX(MIN(input[i], 127), 0);
+#endif
+}
+
+// Returns: the dot product of 'input' (which must be in [0, 127]) and
+//  'weights', each 'count' values long ('count' must be a multiple of 32).
+static inline int32 dot(const uint8 *input, const int8 *weights, int count)
+{
+#if defined(__AVX2__)
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < count; i += 32)
+    {
+        // (maddubs cannot saturate here, since 2 * 127 * 128 < 32768.)
+        __m256i products = _mm256_maddubs_epi16(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i)),
+            _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(weights + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                   _mm256_extracti128_si256(sum, 1));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4e));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xb1));
+    return _mm_cvtsi128_si32(sum128);
+#elif defined(__SSE4_1__)
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < count; i += 16)
+    {
+        __m128i products = _mm_maddubs_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i)));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int32 sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += input[i] * weights[i];
+    return sum;
+#endif
+}
+
+// A dense layer followed by a clipped ReLU.
+template <int numInputs, int numOutputs>
+static inline void hiddenLayer(uint8 *output, const uint8 *input,
+                               const int8 (&weights)[numOutputs] [numInputs],
+                               const int32 *biases)
+{
+    for (int i = 0; i < numOutputs; i++)
+    {
+        int32 sum = (biases[i] + dot(input, weights[i], numInputs)) >>
+            kWeightShift;
+        output[i] = MAX(MIN(sum, 127), 0);
+    }
+}
+
+// Calculates 'perspective's half of an accumulator ('values') from scratch.
+static void refreshPerspective(int16 *values, const Board &board,
+                               uint8 perspective)
+{
+    const NetworkT &net = *gNet;
+    cell_t kingCoord =
+        board.PieceCoords(Piece(perspective, PieceType::King))[0];
+
+    memcpy(values, net.ftBiases, sizeof(net.ftBiases));
+    for (uint8 player = 0; player < NUM_PLAYERS; player++)
+    {
+        for (int type = int(PieceType::Pawn);
+             type <= int(PieceType::Queen);
+             type++)
+        {
+            Piece piece(player, PieceType(type));
+            for (cell_t coord : board.PieceCoords(piece))
+            {
+                addRow(values,
+                       &net.ftWeights[featureIndex(perspective, kingCoord,
+                                                   piece, coord) * kNnueL1]);
+            }
+        }
+    }
+}
+
+void NnueRefresh(NnueAccumulatorT &acc, const Board &board)
+{
+    for (uint8 perspective = 0; perspective < NUM_PLAYERS; perspective++)
+        refreshPerspective(acc.values[perspective], board, perspective);
+    acc.netId = gNnueNetId;
+}
+
+void NnueUpdate(NnueAccumulatorT &acc, const NnueAccumulatorT &parent,
+                const NnueDirtyT &dirty, const Board &board)
+{
+    const NetworkT &net = *gNet;
+    bool kingMoved[NUM_PLAYERS] = {false, false};
+
+    for (int i = 0; i < dirty.count; i++)
+    {
+        if (dirty.pieces[i].piece.IsKing())
+            kingMoved[dirty.pieces[i].piece.Player()] = true;
+    }
+
+    for (uint8 perspective = 0; perspective < NUM_PLAYERS; perspective++)
+    {
+        int16 *values = acc.values[perspective];
+        if (kingMoved[perspective])
+        {
+            // Every feature of this perspective changed.
+            refreshPerspective(values, board, perspective);
+            continue;
+        }
+
+        cell_t kingCoord =
+            board.PieceCoords(Piece(perspective, PieceType::King))[0];
+
+        memcpy(values, parent.values[perspective], sizeof(acc.values[0]));
+        for (int i = 0; i < dirty.count; i++)
+        {
+            Piece piece = dirty.pieces[i].piece;
+            if (piece.IsKing())
+                continue; // (kings are not features)
+            if (dirty.pieces[i].from != FLAG)
+            {
+                subRow(values,
+                       &net.ftWeights[featureIndex(perspective, kingCoord,
+                                                   piece,
+                                                   dirty.pieces[i].from) *
+                                      kNnueL1]);
+            }
+            if (dirty.pieces[i].to != FLAG)
+            {
+                addRow(values,
+                       &net.ftWeights[featureIndex(perspective, kingCoord,
+                                                   piece,
+                                                   dirty.pieces[i].to) *
+                                      kNnueL1]);
+            }
+        }
+    }
+    acc.netId = gNnueNetId;
+}
+
+int NnueEvaluate(const Board &board)
+{
+    const NetworkT &net = *gNet;
+    const NnueAccumulatorT &acc = board.Accumulator();
+    uint8 turn = board.Turn();
+    uint8 input[2 * kNnueL1];
+    uint8 l1Output[kNnueL2];
+    uint8 l2Output[kNnueL3];
+
+    // The side to move always comes first.
+    clipAccumulator(input, acc.values[turn]);
+    clipAccumulator(input + kNnueL1, acc.values[turn ^ 1]);
+
+    hiddenLayer(l1Output, input, net.l1Weights, net.l1Biases);
+    hiddenLayer(l2Output, l1Output, net.l2Weights, net.l2Biases);
+
+    return (net.outBias + dot(l2Output, net.outWeights, kNnueL3)) /
+        kOutputScale;
+}
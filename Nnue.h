@@ -0,0 +1,95 @@
+//--------------------------------------------------------------------------
+//             Nnue.h - efficiently updatable neural net evaluation.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <string>
+
+#include "aTypes.h"
+#include "Piece.h"
+#include "ref.h"
+
+class Board; // forward declaration
+
+// Network layout.  The inputs are "HalfKP" features: for each perspective
+//  (player), every (own king coord, non-king piece, piece coord) triplet.
+//  Coords are mirrored vertically for Black, so both perspectives see the
+//  board from their own side.
+// The first layer is the feature transformer, whose output (the accumulator)
+//  only changes by a few rows per move, so we update it incrementally.  The
+//  (small) dense layers after it are calculated in full for each evaluation.
+const int kNnueFeatures = NUM_SQUARES * 10 * NUM_SQUARES; // per perspective
+const int kNnueL1 = 256; // accumulator size (per perspective)
+const int kNnueL2 = 32;
+const int kNnueL3 = 32;
+
+// Feature transformer output for both perspectives, indexed by player.
+struct NnueAccumulatorT
+{
+    int16 values[NUM_PLAYERS] [kNnueL1];
+    uint32 netId; // network these values belong to (0 -> not calculated)
+};
+
+// Pieces that changed coords during a move.  'from' is FLAG for an added
+//  piece, and 'to' is FLAG for a removed one.  (A capture-promotion changes
+//  three pieces, which is as bad as it gets.)
+struct NnueDirtyT
+{
+    struct
+    {
+        Piece piece;
+        cell_t from;
+        cell_t to;
+    } pieces[3];
+    int count;
+
+    inline void Add(Piece piece, cell_t from, cell_t to);
+};
+
+// Id of the currently loaded network, or 0 if none is loaded (in which case
+//  we use the normal evaluation).  Every load gets a new id, which lets us
+//  notice stale accumulators.
+extern uint32 gNnueNetId;
+
+inline uint32 NnueNetId()
+{
+    return gNnueNetId;
+}
+
+// Loads the network in 'fileName' (or unloads any network, if 'fileName' is
+//  empty).  This must not be called while searching.
+// Returns: true iff succeeded.  On failure, no network is loaded.
+bool NnueLoad(const std::string &fileName);
+
+// Calculates 'acc' from scratch for 'board'.
+void NnueRefresh(NnueAccumulatorT &acc, const Board &board);
+// Calculates 'acc' from 'parent' (the accumulator before the move that
+//  changed 'dirty').  'board' is the position after the move.  If a king
+//  moved, its own perspective is refreshed instead.
+void NnueUpdate(NnueAccumulatorT &acc, const NnueAccumulatorT &parent,
+                const NnueDirtyT &dirty, const Board &board);
+
+// Returns: the network's evaluation of 'board', from the point of view of the
+//  side to move.  Requires a loaded network.
+int NnueEvaluate(const Board &board);
+
+inline void NnueDirtyT::Add(Piece piece, cell_t from, cell_t to)
+{
+    pieces[count].piece = piece;
+    pieces[count].from = from;
+    pieces[count].to = to;
+    count++;
+}
+
+#endif // NNUE_H
@@ -0,0 +1,171 @@
+//--------------------------------------------------------------------------
+//           Pawns.cpp - pawn structure evaluation (and hashing).
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#include <vector>
+
+#include "EvalParams.h"
+#include "Pawns.h"
+
+using arctic::File;
+using arctic::Rank;
+
+// Must be a power of 2.  Pawn structures change rarely during a search, so
+//  even a small table gets a very high hit rate.
+static const int kNumEntries = 4096;
+
+namespace // start unnamed namespace
+{
+
+class PawnTable
+{
+public:
+    PawnTable();
+    inline const PawnInfoT &Lookup(const Board &board);
+    void Clear();
+private:
+    std::vector<PawnInfoT> entries;
+    void calc(PawnInfoT &info, const Board &board) const;
+};
+
+} // end unnamed namespace
+
+static thread_local PawnTable gPawnTable;
+
+static const uint64 kFileAMask = 0x0101010101010101ULL;
+
+static inline uint64 fileMask(int file)
+{
+    return kFileAMask << file;
+}
+
+static inline uint64 adjacentFilesMask(int file)
+{
+    return (file > 0 ? fileMask(file - 1) : 0) |
+        (file < 7 ? fileMask(file + 1) : 0);
+}
+
+static inline uint64 rankMask(int rank)
+{
+    return rank < 0 || rank > 7 ? 0 : uint64(0xff) << (rank * 8);
+}
+
+// Returns: all squares on ranks strictly in front of 'rank', from 'player's
+//  point of view.
+static inline uint64 ranksAheadMask(uint8 player, int rank)
+{
+    return player == 0 ?
+        (rank >= 7 ? 0 : ~uint64(0) << ((rank + 1) * 8)) :
+        (rank <= 0 ? 0 : ~uint64(0) >> ((8 - rank) * 8));
+}
+
+PawnTable::PawnTable() : entries(kNumEntries)
+{
+    Clear();
+}
+
+void PawnTable::Clear()
+{
+    // Make sure every entry (re)starts out as a miss.  (A key of 0 is valid
+    //  (no pawns), so we cannot rely on zero-initialization.)
+    for (int i = 0; i < kNumEntries; i++)
+        entries[i].key = ~uint64(0);
+}
+
+inline const PawnInfoT &PawnTable::Lookup(const Board &board)
+{
+    uint64 key = board.PawnZobrist();
+    PawnInfoT &info = entries[key & (kNumEntries - 1)];
+
+    if (info.key != key)
+        calc(info, board);
+    return info;
+}
+
+void PawnTable::calc(PawnInfoT &info, const Board &board) const
+{
+    const EvalParamsT &params = gEvalParams; // shorthand
+
+    info.key = board.PawnZobrist();
+
+    for (uint8 player = 0; player < NUM_PLAYERS; player++)
+    {
+        info.pawns[player] = 0;
+        for (cell_t coord : board.PieceCoords(Piece(player, PieceType::Pawn)))
+            info.pawns[player] |= uint64(1) << coord;
+    }
+
+    for (uint8 player = 0; player < NUM_PLAYERS; player++)
+    {
+        uint64 mine = info.pawns[player];
+        uint64 theirs = info.pawns[player ^ 1];
+        int forward = player == 0 ? 1 : -1; // (in ranks)
+        PhasedScoreT score = {0, 0};
+
+        info.passed[player] = 0;
+        for (cell_t coord : board.PieceCoords(Piece(player, PieceType::Pawn)))
+        {
+            int file = File(coord), rank = Rank(coord);
+            int relativeRank = player == 0 ? rank : 7 - rank;
+            uint64 ahead = ranksAheadMask(player, rank);
+            uint64 neighbors = mine & adjacentFilesMask(file);
+
+            if (!(theirs & ahead & (fileMask(file) | adjacentFilesMask(file))))
+            {
+                info.passed[player] |= uint64(1) << coord;
+                score += params.passed[relativeRank];
+            }
+            if (mine & ahead & fileMask(file))
+                score += params.doubled;
+            if (!neighbors)
+                score += params.isolated;
+            // No neighbor is level with (or behind) this pawn to support it,
+            //  and an enemy pawn stops it from advancing.
+            else if (!(neighbors & ~ahead) &&
+                     (theirs & adjacentFilesMask(file) &
+                      rankMask(rank + 2 * forward)))
+            {
+                score += params.backward;
+            }
+        }
+        info.score[player] = score;
+
+        // Calculate pawn shields for each king file.
+        int rank2 = player == 0 ? 1 : 6, rank3 = player == 0 ? 2 : 5;
+        for (int kingFile = 0; kingFile < 8; kingFile++)
+        {
+            int shield = 0;
+            for (int file = MAX(kingFile - 1, 0);
+                 file <= MIN(kingFile + 1, 7);
+                 file++)
+            {
+                shield +=
+                    mine & fileMask(file) & rankMask(rank2) ?
+                    params.shieldRank2 :
+                    mine & fileMask(file) & rankMask(rank3) ?
+                    params.shieldRank3 :
+                    params.shieldMissing;
+            }
+            info.shield[player] [kingFile] = shield;
+        }
+    }
+}
+
+const PawnInfoT &PawnLookup(const Board &board)
+{
+    return gPawnTable.Lookup(board);
+}
+
+void PawnClearCache()
+{
+    gPawnTable.Clear();
+}
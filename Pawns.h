@@ -0,0 +1,57 @@
+//--------------------------------------------------------------------------
+//            Pawns.h - pawn structure evaluation (and hashing).
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include "aTypes.h"
+#include "Board.h"
+#include "Pst.h"
+#include "ref.h"
+
+// Everything that can be derived from just the pawns on the board.
+// Masks have one bit per coord (bit 0 == a1).
+struct PawnInfoT
+{
+    uint64 key;                   // pawn key this information is valid for.
+    uint64 pawns[NUM_PLAYERS];    // each side's pawns.
+    uint64 passed[NUM_PLAYERS];   // each side's passed pawns.
+    // Structure (passed/isolated/doubled/backward pawns) score of each side,
+    //  from that side's point of view.
+    PhasedScoreT score[NUM_PLAYERS];
+    // Middlegame pawn shield score of each side, for a king sitting on its
+    //  back two ranks, indexed by the king's file.  (This sums three of the
+    //  (tunable) shield weights, so it needs more than a byte.)
+    int16 shield[NUM_PLAYERS] [8];
+
+    // Returns: the pawn score of 'player' (whose king sits at 'kingCoord').
+    inline PhasedScoreT Score(uint8 player, cell_t kingCoord) const;
+};
+
+// Returns information about the pawns on 'board'.  This is cached per-thread
+//  (by Board::PawnZobrist()), so it is usually a simple table lookup.
+const PawnInfoT &PawnLookup(const Board &board);
+// Forgets everything the calling thread has cached (needed when the pawn
+//  weights in gEvalParams change).
+void PawnClearCache();
+
+inline PhasedScoreT PawnInfoT::Score(uint8 player, cell_t kingCoord) const
+{
+    int relativeRank =
+        player == 0 ? arctic::Rank(kingCoord) : 7 - arctic::Rank(kingCoord);
+    return relativeRank > 1 ? score[player] :
+        score[player] +
+        PhasedScoreT{shield[player] [arctic::File(kingCoord)], 0};
+}
+
+#endif // PAWNS_H
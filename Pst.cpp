@@ -0,0 +1,37 @@
+//--------------------------------------------------------------------------
+//                Pst.cpp - piece-square table evaluation.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#include "EvalParams.h"
+#include "gPreCalc.h"
+#include "Pst.h"
+
+PhasedScoreT PstValue(Piece piece, cell_t coord)
+{
+    // Convert 'coord' (a1 == 0) to a diagram index from the owner's point of
+    //  view.
+    int idx = piece.Player() == 0 ? coord ^ 56 : coord;
+
+    return gEvalParams.pst[int(piece.Type())] [idx];
+}
+
+void PstRefresh()
+{
+    for (int i = 0; i < NUM_SQUARES; i++)
+    {
+        for (int j = 0; j < kMaxPieces; j++)
+        {
+            Piece piece(j & NUM_PLAYERS_MASK, PieceType(j >> NUM_PLAYERS_BITS));
+            gPreCalc.pst[j] [i] = PstValue(piece, i);
+        }
+    }
+}
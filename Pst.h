@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------
+//                 Pst.h - piece-square table evaluation.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#ifndef PST_H
+#define PST_H
+
+#include "Material.h"
+#include "Piece.h"
+#include "ref.h"
+
+// An evaluation term with separate middlegame and endgame weights.  These are
+//  summed up separately, and only blended (according to the game phase) when
+//  the final score is needed.
+struct PhasedScoreT
+{
+    int mg; // middlegame weight
+    int eg; // endgame weight
+
+    inline PhasedScoreT &operator+=(const PhasedScoreT &other);
+    inline PhasedScoreT &operator-=(const PhasedScoreT &other);
+    inline PhasedScoreT operator+(const PhasedScoreT &other) const;
+    inline PhasedScoreT operator-(const PhasedScoreT &other) const;
+    inline bool operator!=(const PhasedScoreT &other) const;
+
+    // Returns: the score at 'phase' (see MaterialInfoT::phase).
+    inline int Blend(int phase) const;
+};
+
+// Returns: the positional (not material) worth of 'piece' when it sits on
+//  'coord', from the point of view of the piece's owner.  (This is 0 for empty
+//  squares.)  Used to fill in gPreCalc.pst, which Board sums up incrementally
+//  (see Board::PositionalScore()).  The tables themselves are in gEvalParams
+//  (see EvalParams.h).
+PhasedScoreT PstValue(Piece piece, cell_t coord);
+
+// (Re)fills gPreCalc.pst (from the tables in gEvalParams).
+void PstRefresh();
+
+inline PhasedScoreT &PhasedScoreT::operator+=(const PhasedScoreT &other)
+{
+    mg += other.mg;
+    eg += other.eg;
+    return *this;
+}
+
+inline PhasedScoreT &PhasedScoreT::operator-=(const PhasedScoreT &other)
+{
+    mg -= other.mg;
+    eg -= other.eg;
+    return *this;
+}
+
+inline PhasedScoreT PhasedScoreT::operator+(const PhasedScoreT &other) const
+{
+    return PhasedScoreT{mg + other.mg, eg + other.eg};
+}
+
+inline PhasedScoreT PhasedScoreT::operator-(const PhasedScoreT &other) const
+{
+    return PhasedScoreT{mg - other.mg, eg - other.eg};
+}
+
+inline bool PhasedScoreT::operator!=(const PhasedScoreT &other) const
+{
+    return mg != other.mg || eg != other.eg;
+}
+
+inline int PhasedScoreT::Blend(int phase) const
+{
+    return (mg * phase + eg * (MaterialInfoT::kMaxPhase - phase)) /
+        MaterialInfoT::kMaxPhase;
+}
+
+#endif // PST_H
@@ -16,6 +16,7 @@
 
 #include "Board.h"
 #include "move.h" // MovesToString()
+#include "MoveList.h"
 #include "Pv.h"
 
 SearchPv &SearchPv::operator=(const SearchPv &other)
@@ -29,52 +30,6 @@ SearchPv &SearchPv::operator=(const SearchPv &other)
     return *this;
 }
 
-// As a convenience, returns true iff this is the root node.
-bool SearchPv::updateFromChildPv(MoveT move, const SearchPv *child)
-{
-    if (child != nullptr && child->startDepth != startDepth + 1)
-    {
-        LOG_EMERG("%s: ERROR! startDepths wrong: mine %d, child %d\n",
-                  __func__, startDepth, child->startDepth);
-    }
-    
-    if (move == MoveNone)
-    {
-        // Once we have a move, we should never UpdatePv() with MoveNone.
-        // (because MoveNone should only happen on a fail-low)
-        if (numMoves > 0)
-        {
-            assert(0);
-        }
-        // Assuming we didn't assert, this case is a no-op (because numMoves
-        //  already == 0).
-    }
-    // When startDepth >= kMaxPvMoves, it's useless to update, since this
-    //  cannot percolate back to the root node.
-    else if (startDepth < kMaxPvMoves)
-    {
-        moves[0] = move;
-
-        if (child == nullptr)
-        {
-            numMoves = 1;
-        }
-        else
-        {
-            int movesToCopy = MIN(child->numMoves,
-                                  kMaxPvMoves - 1 - startDepth);
-            numMoves = movesToCopy + 1;
-            if (movesToCopy > 0)
-            {
-                std::copy(&child->moves[0], &child->moves[movesToCopy],
-                          &moves[1]);
-            }
-        }
-    }
-
-    return startDepth == 0;
-}
-
 // Writes out a sequence of moves in the PV using style 'moveStyle'.
 // Returns the number of moves successfully converted.
 int SearchPv::BuildMoveString(char *dstStr, int dstLen,
@@ -89,10 +44,13 @@ int SearchPv::BuildMoveString(char *dstStr, int dstLen,
 bool SearchPv::Sanitize(const Board &board)
 {
     Board tmpBoard(board);
+    MoveList moveList;
 
     for (int i = 0; i < numMoves; i++)
     {
-        if (!tmpBoard.IsLegalMove(moves[i]))
+        tmpBoard.GenerateLegalMoves(moveList, false);
+        const MoveT *legalMove = moveList.SearchSrcDstPromote(moves[i]);
+        if (legalMove == nullptr)
         {
             MoveStyleT badMoveStyle = {mnDebug, csOO, false};
             char tmpStr[MOVE_STRING_MAX];
@@ -107,6 +65,9 @@ bool SearchPv::Sanitize(const Board &board)
             numMoves = i;
             return false;
         }
+        // Moves from the transposition table do not know if they give check,
+        //  so take the move generator's version.
+        moves[i] = *legalMove;
         // Advance to next move so we can check it.
         tmpBoard.MakeMove(moves[i]);
     }
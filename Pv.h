@@ -20,9 +20,13 @@
 #ifndef PV_H
 #define PV_H
 
+#include <algorithm> // std::copy
+#include <assert.h>
+
 #include "Eval.h"
 #include "log.h"
 #include "move.h"
+#include "ref.h"
 
 class Board; // forward decl
 
@@ -31,32 +35,68 @@ class Board; // forward decl
 static const int kMaxPvMoves = 20;
 static const int kMaxPvStringLen = (kMaxPvMoves * MOVE_STRING_MAX);
 
-// A "fast" but limited version of PV tracking.  Used by the thinker to track
-//  its PV as it is searching.  Could be used for other variations than the
-//  principal one.
+// A non-owning reference to a line of moves.  Only valid until whoever owns
+//  the moves next changes them.
+struct PvRefT
+{
+    const MoveT *moves;
+    int numMoves;
+};
+
+// A per-thread "triangular" PV table, used while searching.  Row 'ply' holds
+//  the best line found from the node at that ply.  That line can be at most
+//  (kMaxPvMoves - ply) moves long (anything longer could not percolate back to
+//  the root anyway), so each row is one move shorter than the last.
+// Updating a row copies only the child's actual line, in place.
+class PvTable
+{
+public:
+    PvTable();
+
+    inline void Clear(int ply);
+
+    // As a convenience, these return true iff this is the root node.
+    inline bool Update(int ply, MoveT move);
+    // As above, but appends the line from row 'ply + 1'.
+    inline bool UpdateFromChild(int ply, MoveT move);
+
+    // Replace row 'ply' with 'line' (found by a sub-searcher, say).
+    inline void Set(int ply, const PvRefT &line);
+
+    inline PvRefT Line(int ply) const;
+    // Returns move 'idx' of row 'ply' (or MoveNone if there is none).
+    inline MoveT Moves(int ply, int idx) const;
+
+private:
+    static inline int rowStart(int ply);
+    int numMoves[kMaxPvMoves];
+    MoveT moves[kMaxPvMoves * (kMaxPvMoves + 1) / 2];
+};
+
+// A "fast" but limited line of moves, starting at some depth of the search.
+//  (While searching, the thinker tracks lines w/a PvTable instead; this is
+//  used to hand a line off to someone else.)  Could be used for other
+//  variations than the principal one.
 class SearchPv
 {
 public:
     explicit SearchPv(int startDepth);
+    SearchPv(int startDepth, const PvRefT &line);
     SearchPv &operator=(const SearchPv &other);
 
     void Clear();
 
-    // As a convenience, these return true iff this is the root node.
-    bool Update(MoveT move);
-    bool UpdateFromChildPv(MoveT move, const SearchPv &child);
-
     // Writes out a sequence of moves in the PV using style 'moveStyle'.
     // Returns the number of moves successfully converted.
     int BuildMoveString(char *dstStr, int dstLen,
                         const MoveStyleT &moveStyle, const Board &board) const;
     // Adjusts the PV to contain only legal moves (might be necessary due to
-    //  zobrist collisions in the transposition table, for instance).  Returns
-    //  'true' iff no illegal moves were found.
+    //  zobrist collisions in the transposition table, for instance), and
+    //  fills in each move's 'chk'.  Returns 'true' iff no illegal moves were
+    //  found.
     bool Sanitize(const Board &board);
     MoveT Moves(int idx) const;
     void Log(LogLevelT logLevel) const;
-    void SetStartDepth(int depth);
     void Decrement(); // assumes we play the move at Moves(0) (if any)
 
 private:
@@ -67,8 +107,6 @@ private:
                   //  kMaxPvDepth; could be higher as well with a lot of
                   //  q-moves.)
     MoveT moves[kMaxPvMoves];
-
-    bool updateFromChildPv(MoveT move, const SearchPv *child);
 };
 
 // Pv class sent in Thinker -> UI notifications.
@@ -145,32 +183,96 @@ private:
 };
 
 
-inline SearchPv::SearchPv(int startDepth) : startDepth(startDepth), numMoves(0)
-{}
+inline PvTable::PvTable()
+{
+    std::fill(&numMoves[0], &numMoves[kMaxPvMoves], 0);
+}
 
-inline void SearchPv::Clear()
+inline int PvTable::rowStart(int ply)
 {
-    numMoves = 0;
+    return ply * kMaxPvMoves - ((ply * (ply - 1)) >> 1);
 }
 
-inline bool SearchPv::Update(MoveT move)
+inline void PvTable::Clear(int ply)
 {
-    return updateFromChildPv(move, nullptr);
+    if (ply < kMaxPvMoves)
+        numMoves[ply] = 0;
 }
 
-inline bool SearchPv::UpdateFromChildPv(MoveT move, const SearchPv &child)
+inline bool PvTable::Update(int ply, MoveT move)
 {
-    return updateFromChildPv(move, &child);
+    if (ply < kMaxPvMoves && move != MoveNone)
+    {
+        moves[rowStart(ply)] = move;
+        numMoves[ply] = 1;
+    }
+    return ply == 0;
 }
 
-inline MoveT SearchPv::Moves(int idx) const
+inline bool PvTable::UpdateFromChild(int ply, MoveT move)
 {
-    return idx < 0 || idx >= numMoves ? MoveNone : moves[idx];
+    // Once we have a move, we should never update with MoveNone (because
+    //  MoveNone should only happen on a fail-low).
+    assert(move != MoveNone || ply >= kMaxPvMoves || numMoves[ply] == 0);
+
+    if (ply < kMaxPvMoves && move != MoveNone)
+    {
+        MoveT *row = &moves[rowStart(ply)];
+        int movesToCopy = ply + 1 >= kMaxPvMoves ? 0 :
+            MIN(numMoves[ply + 1], kMaxPvMoves - 1 - ply);
+
+        row[0] = move;
+        std::copy(&moves[rowStart(ply + 1)],
+                  &moves[rowStart(ply + 1) + movesToCopy], &row[1]);
+        numMoves[ply] = movesToCopy + 1;
+    }
+    return ply == 0;
+}
+
+inline void PvTable::Set(int ply, const PvRefT &line)
+{
+    if (ply < kMaxPvMoves)
+    {
+        numMoves[ply] = MIN(line.numMoves, kMaxPvMoves - ply);
+        std::copy(line.moves, line.moves + numMoves[ply],
+                  &moves[rowStart(ply)]);
+    }
+}
+
+inline PvRefT PvTable::Line(int ply) const
+{
+    PvRefT result = {nullptr, 0};
+    if (ply < kMaxPvMoves)
+    {
+        result.moves = &moves[rowStart(ply)];
+        result.numMoves = numMoves[ply];
+    }
+    return result;
+}
+
+inline MoveT PvTable::Moves(int ply, int idx) const
+{
+    return ply >= kMaxPvMoves || idx < 0 || idx >= numMoves[ply] ? MoveNone :
+        moves[rowStart(ply) + idx];
+}
+
+inline SearchPv::SearchPv(int startDepth) : startDepth(startDepth), numMoves(0)
+{}
+
+inline SearchPv::SearchPv(int startDepth, const PvRefT &line) :
+    startDepth(startDepth), numMoves(MIN(line.numMoves, kMaxPvMoves))
+{
+    std::copy(line.moves, line.moves + numMoves, moves);
+}
+
+inline void SearchPv::Clear()
+{
+    numMoves = 0;
 }
 
-inline void SearchPv::SetStartDepth(int depth)
+inline MoveT SearchPv::Moves(int idx) const
 {
-    startDepth = depth;
+    return idx < 0 || idx >= numMoves ? MoveNone : moves[idx];
 }
 
 inline DisplayPv::DisplayPv() : level(0), pv(0) {}
@@ -0,0 +1,115 @@
+//--------------------------------------------------------------------------
+//             SearchStack.h - per-ply state used while searching.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+#ifndef SEARCHSTACK_H
+#define SEARCHSTACK_H
+
+#include <climits> // INT_MIN
+#include <memory>  // std::unique_ptr
+
+#include "move.h"
+#include "MoveList.h"
+#include "Pv.h"
+
+// Max depth (including quiescing) we can search to.  This needs to
+//  comfortably exceed the max search level (100) plus the longest capture
+//  sequence we might quiesce through.
+const int kMaxPly = 256;
+
+// Number of killer moves tracked per ply.
+const int kNumKillers = 2;
+
+// PlyT::staticEval of a node that only got a lazy (partial) eval.
+const int kNoStaticEval = INT_MIN;
+
+// Search state for each ply (searching from root == 0), kept in one
+//  contiguous array per thinker instead of in minimax()'s locals.  This
+//  avoids re-constructing the state at each node, and lets a node look at its
+//  parent's (or grandparent's) state at [ply - 1] (or [ply - 2]).
+class SearchStack
+{
+public:
+    struct PlyT
+    {
+        MoveList mvlist;    // moves to be searched from this node.
+        MoveT killers[kNumKillers]; // quiet moves that caused a cutoff at
+                                    //  this ply (most recent first).
+        int staticEval;     // full static eval of this node (from the
+                            //  side to move's view, without any draw
+                            //  bias), or kNoStaticEval if it only got a
+                            //  lazy one.
+        MoveT excludedMove; // Move to skip when searching this node (for
+                            //  verification searches), normally MoveNone.
+    };
+
+    SearchStack();
+
+    // Must be fast, so as with normal arrays, 'ply' is not sanity-checked.
+    inline PlyT &operator[](int ply);
+
+    // Best line found from each ply (row 'ply' belongs to stack[ply]).
+    inline PvTable &Pv();
+
+    // Forget all killers (say, before searching a new position).
+    inline void ClearKillers();
+
+    // Record 'move' as a killer at 'ply'.
+    inline void StoreKiller(int ply, MoveT move);
+
+private:
+    std::unique_ptr<PlyT[]> plies;
+    PvTable pvTable;
+};
+
+inline SearchStack::SearchStack() : plies(new PlyT[kMaxPly])
+{
+    for (int i = 0; i < kMaxPly; i++)
+    {
+        plies[i].excludedMove = MoveNone;
+        plies[i].staticEval = kNoStaticEval;
+    }
+    ClearKillers();
+}
+
+inline SearchStack::PlyT &SearchStack::operator[](int ply)
+{
+    return plies[ply];
+}
+
+inline PvTable &SearchStack::Pv()
+{
+    return pvTable;
+}
+
+inline void SearchStack::ClearKillers()
+{
+    for (int i = 0; i < kMaxPly; i++)
+    {
+        for (int j = 0; j < kNumKillers; j++)
+            plies[i].killers[j] = MoveNone;
+    }
+}
+
+inline void SearchStack::StoreKiller(int ply, MoveT move)
+{
+    MoveT *killers = plies[ply].killers;
+
+    if (killers[0] != move)
+    {
+        for (int j = kNumKillers - 1; j > 0; j--)
+            killers[j] = killers[j - 1];
+        killers[0] = move;
+    }
+}
+
+#endif // SEARCHSTACK_H
@@ -20,6 +20,10 @@
 
 Thinker *Thinker::rootThinker = nullptr;
 
+// (In centipawns.)  Large enough that the terms EvaluateLazy() skips almost
+//  never make up the difference.
+static const int kDefaultLazyEvalMargin = 300;
+
 // An internal global resource.  Might be split later if we need sub-searchers.
 struct SearcherGroupT
 {
@@ -125,7 +129,10 @@ static bigtime_t calcGoalTime(const Board &board, const Clock &myClock)
     return MAX(calcTime, 0);
 }
 
-Thinker::ContextT::ContextT() : maxDepth(0), depth(0)
+Thinker::ContextT::ContextT() :
+    maxDepth(0), depth(0), nodes(0), reportedNodes(0), evalCacheProbes(0),
+    evalCacheHits(0), lazyEvals(0), fullEvals(0), hashStats(),
+    drawPly(NoDrawPly)
 {
     searchArgs.alpha = Eval::Loss;
     searchArgs.beta = Eval::Win;
@@ -134,7 +141,9 @@ Thinker::ContextT::ContextT() : maxDepth(0), depth(0)
 
 Thinker::SharedContextT::SharedContextT() :
     maxLevel(DepthNoLimit), maxNodes(0), randomMoves(false), canResign(true),
-    maxThreads(SystemTotalProcessors()), gameCount(0) {}
+    hashDiagnostics(false),
+    lazyEvalMargin(kDefaultLazyEvalMargin),
+    maxThreads(SystemTotalProcessors()), totalNodes(0), gameCount(0) {}
 
 Thinker::Thinker(EventQueue &rspQueue, const RspHandlerT &handler) :
     cmdQueue(std::unique_ptr<Pollable>(new Pollable)), rspQueue(rspQueue),
@@ -189,9 +198,10 @@ void Thinker::RspResign()
     moveToIdleState();
 }
 
-void Thinker::RspSearchDone(MoveT move, Eval eval, const SearchPv &pv)
+void Thinker::RspSearchDone(MoveT move, Eval eval, uint64 nodes,
+                            int drawPly, const PvRefT &pv)
 {
-    EngineSearchDoneArgsT args = {move, eval, pv};
+    EngineSearchDoneArgsT args = {move, eval, nodes, drawPly, pv};
     rspQueue.Post(std::bind(rspHandler.SearchDone, args));
     moveToIdleState();
 }
@@ -229,7 +239,10 @@ void Thinker::onMoveTimerExpired(int epoch)
 {
     // In the future, this could be more intelligent.
     if (this->epoch == epoch)
+    {
+        SignalMoveNow();
         PostCmd(std::bind(&Thinker::OnCmdMoveNow, this));
+    }
 }
 
 void Thinker::OnCmdMoveNow()
@@ -237,12 +250,15 @@ void Thinker::OnCmdMoveNow()
     // Ignore MoveNows received after our move timer expires.
     if (state == State::Idle)
         return;
-    moveNow = true;
+    SignalMoveNow();
     // Perhaps, we should also signal any sub-searchers to move.
 }
 
 void Thinker::OnCmdThink()
 {
+    // (Any SignalMoveNow() that raced with our last search finishing was
+    //  meant for that search, not this one.)
+    moveNow = false;
     bigtime_t goalTime = calcGoalTime(context.board, context.clock);
     if (goalTime != CLOCK_TIME_INFINITE)
     {
@@ -256,24 +272,28 @@ void Thinker::OnCmdThink()
 
 void Thinker::OnCmdPonder()
 {
+    moveNow = false;
     state = State::Pondering;
     computermove(this, true);
 }
 
 void Thinker::OnCmdSearch()
 {
+    moveNow = false;
     state = State::Searching;
 
-    // If we make the constructor use a memory pool, we should probably
-    //  still micro-optimize this.
-    SearchPv pv(context.depth + 1);
+    uint64 startNodes = context.nodes;
+    context.drawPly = NoDrawPly;
         
     // Make the appropriate move, bump depth etc.
     Eval eval = tryMove(this, context.searchArgs.move,
                         context.searchArgs.alpha,
-                        context.searchArgs.beta, &pv, nullptr);
+                        context.searchArgs.beta, nullptr);
 
-    RspSearchDone(context.searchArgs.move, eval, pv);
+    // (Do this before responding, so the parent sees an up-to-date count.)
+    ReportNodes();
+    RspSearchDone(context.searchArgs.move, eval, context.nodes - startNodes,
+                  context.drawPly, context.stack.Pv().Line(context.depth + 1));
 }
 
 void Thinker::threadFunc()
@@ -363,7 +383,8 @@ static bool searcherWaitOne()
     assert(0);
 }
 
-bool SearchersWaitOne(Thinker &parent, Eval &eval, MoveT &move, SearchPv &pv)
+bool SearchersWaitOne(Thinker &parent, Eval &eval, MoveT &move,
+                      uint64 &nodes, int &drawPly, PvRefT &pv)
 {
     EngineSearchDoneArgsT &args = parent.Context().searchResult;
 
@@ -372,6 +393,8 @@ bool SearchersWaitOne(Thinker &parent, Eval &eval, MoveT &move, SearchPv &pv)
     {
         eval = args.eval;
         move = args.move;
+        nodes = args.nodes;
+        drawPly = args.drawPly;
         pv = args.pv;
     }
     else
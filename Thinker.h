@@ -14,14 +14,19 @@
 #ifndef THINKER_H
 #define THINKER_H
 
+#include <atomic>     // std::atomic
+#include <climits>    // INT_MAX
 #include <functional> // std::function
 #include <thread>     // std::thread
 
+#include "aSystem.h"  // kCacheLineSize
 #include "Board.h"
 #include "Clock.h"
 #include "EngineTypes.h"
+#include "EvalCache.h"
 #include "EventQueue.h"
 #include "MoveList.h"
+#include "SearchStack.h"
 #include "Timer.h"
 
 class Thinker
@@ -57,6 +62,14 @@ public:
     void OnCmdSearch();
 
     inline int PollOneCmd(); // poll the internal cmdqueue.
+    // Thread-safe.  Makes an in-progress search stop as soon as it next
+    //  checks NeedsToMove(), without waiting for a (posted) OnCmdMoveNow() to
+    //  make its way through the cmdqueue.  Callers should still post that
+    //  command too, in case we are blocked waiting on the cmdqueue.
+    inline void SignalMoveNow();
+    // Adds the nodes we have searched (and our eval cache and transposition
+    //  table counts) since the last call to 'stats' (and 'totalNodes').
+    inline void ReportNodes();
     
     // Currently, only claimed draws use RspDraw().  Automatic draws use
     // RspMove().
@@ -65,7 +78,8 @@ public:
     void RspResign();
     void RspNotifyStats(const EngineStatsT &stats) const;
     void RspNotifyPv(const EngineStatsT &stats, const DisplayPv &pv) const;
-    void RspSearchDone(MoveT move, Eval eval, const SearchPv &pv);
+    void RspSearchDone(MoveT move, Eval eval, uint64 nodes, int drawPly,
+                       const PvRefT &pv);
     inline bool NeedsToMove() const;
 
     enum class State : uint8
@@ -79,22 +93,45 @@ public:
     inline bool IsRootThinker() const;
     static inline Thinker &RootThinker();
 
+    // (see ContextT::drawPly)
+    static const int NoDrawPly = INT_MAX;
+
     struct ContextT
     {
         ContextT();      // ctor
         Board board;     // Internal board, used (and clobbered) by
                          //  think/ponder/search.  Set by CmdSetBoard().
         Clock clock;     // Time we started thinking.  Set by CmdThink().
-        MoveList mvlist; // Limited list of moves we are allowed to think or
-                         //  ponder on.  When empty (the usual state), we
-                         //  think/ponder on all moves.  Set by CmdThink() and
-                         //  CmdPonder().
+        RootMoveList mvlist; // Limited list of moves we are allowed to think
+                             //  or ponder on.  When empty (the usual state),
+                             //  we think/ponder on all moves.  Set by
+                             //  CmdThink() and CmdPonder(); computermove()
+                             //  then fills it in (if empty), and re-sorts it
+                             //  between iterations.
         int maxDepth;    // Depth we are authorized to search at (can break this
                          //  w/quiescing).  "maxDepth == 0" implies that we can
                          //  make one half-move/ply, and then we must evaluate
                          //  (or quiesce).
         int depth;       // Depth we are currently searching at (searching from
                          //  root == 0).
+        uint64 nodes;    // Nodes searched by this thinker.  Unlike
+                         //  'stats.nodes', this is not shared with other
+                         //  thinkers, so deltas can be attributed to a
+                         //  particular subtree.
+        uint64 reportedNodes; // How much of 'nodes' is already counted in
+                              //  'stats.nodes' (see ReportNodes()).
+        int evalCacheProbes; // Not yet reported, like 'nodes'.
+        int evalCacheHits;
+        int lazyEvals;
+        int fullEvals;
+        HashStatsT hashStats; // Also not yet reported (only the counts are
+                              //  used).
+        int drawPly;     // Earliest ply whose position a draw (or repetition)
+                         //  found in the current subtree depended on, or
+                         //  NoDrawPly.  If this is before the ply of the
+                         //  subtree's root, the root's result depended on
+                         //  how we got there.  (See tryMove().)
+        SearchStack stack; // Per-ply search state, indexed by 'depth'.
 
         struct
         {
@@ -120,18 +157,26 @@ public:
         //  'maxDepth' is manipulated by the engine.
         volatile int maxLevel;
         // Config variable.  0 == no limit.  Max nodes we are authorized to
-        //  search.
+        //  search.  Only checked every so often (against 'totalNodes') so
+        //  we may overshoot it slightly.
         volatile int maxNodes;
         volatile bool randomMoves;
         volatile bool canResign;
+        volatile bool hashDiagnostics; // check hash hits for collisions?
+        // Config variable.  0 == disabled.  See EvaluateLazy().
+        volatile int lazyEvalMargin;
         int maxThreads; // max searcher threads.
 
         // State that is shared between local thinkers because it would be
         //  a bad idea to not do so.
         HintPv pv; // Attempts to track the principal variation.
         EngineStatsT stats;
+        // Nodes searched by all thinkers in the current search, as of their
+        //  last ReportNodes().  Unlike 'stats.nodes', this is exact.
+        std::atomic<uint64> totalNodes;
         int gameCount; // for debugging.
         TransTable transTable; // transposition table.
+        EvalCache evalCache; // static eval cache.
     };
     // (used by engine to track/manipulate internal state shared between
     //  threads)
@@ -149,7 +194,13 @@ private:
     // Private state:
     State state;
     int epoch;
-    bool moveNow; // Signals that we should move.
+
+    // Signals that we should move.  The search polls this constantly, and
+    //  other threads may set it (see SignalMoveNow()), so it is padded out to
+    //  its own cache line.
+    char moveNowPad0[kCacheLineSize];
+    std::atomic<bool> moveNow;
+    char moveNowPad1[kCacheLineSize - sizeof(std::atomic<bool>)];
 
     // There is (currently) one 'master' thinker that coordinates all of the
     //  other thinkers, which act as search threads.
@@ -165,9 +216,35 @@ inline int Thinker::PollOneCmd()
     return cmdQueue.PollOne();
 }
 
+inline void Thinker::SignalMoveNow()
+{
+    moveNow.store(true, std::memory_order_relaxed);
+}
+
+inline void Thinker::ReportNodes()
+{
+    EngineStatsT &stats = sharedContext->stats; // shorthand
+    uint64 newNodes = context.nodes - context.reportedNodes;
+    context.reportedNodes = context.nodes;
+    // (Copying the total, instead of adding to 'stats.nodes', means a racing
+    //  thinker can only make it briefly stale, not lose nodes for good.)
+    uint64 totalNodes = sharedContext->totalNodes.fetch_add(
+        newNodes, std::memory_order_relaxed) + newNodes;
+    stats.nodes = int(MIN(totalNodes, uint64(INT_MAX)));
+    stats.evalCacheProbes += context.evalCacheProbes;
+    stats.evalCacheHits += context.evalCacheHits;
+    context.evalCacheProbes = context.evalCacheHits = 0;
+    stats.lazyEvals += context.lazyEvals;
+    stats.fullEvals += context.fullEvals;
+    context.lazyEvals = context.fullEvals = 0;
+    // (Every transposition table cutoff is a good hit.)
+    stats.hashHitGood += stats.hash.AddCounts(context.hashStats);
+    context.hashStats = HashStatsT();
+}
+
 inline bool Thinker::NeedsToMove() const
 {
-    return moveNow;
+    return moveNow.load(std::memory_order_relaxed);
 }
 
 inline bool Thinker::IsRootThinker() const
@@ -194,7 +271,8 @@ inline Thinker::SharedContextT &Thinker::SharedContext()
 bool SearchersDelegateSearch(int alpha, int beta, MoveT move, int curDepth,
                              int maxDepth);
 // Returns 'true' if interrupted by the cmdqueue; or 'false' otherwise.
-bool SearchersWaitOne(Thinker &parent, Eval &eval, MoveT &move, SearchPv &pv);
+bool SearchersWaitOne(Thinker &parent, Eval &eval, MoveT &move,
+                      uint64 &nodes, int &drawPly, PvRefT &pv);
 void SearchersBail();
 void SearchersMakeMove(MoveT move);
 void SearchersUnmakeMove();
@@ -12,17 +12,24 @@
 //--------------------------------------------------------------------------
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>    // open(2)
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h> // fstat(2)
+#include <unistd.h>   // pread(2)
+
+#include <vector>
 
-#include "aSpinlock.h"
 #include "aSystem.h"
 #include "aTypes.h"
+#include "gPreCalc.h"
 #include "log.h"
 #include "TransTable.h"
 #include "uiUtil.h"
 
-using arctic::Spinlock;
-
 #ifdef ENABLE_DEBUG_LOGGING
 static const MoveStyleT gMoveStyleTT = { mnCAN, csOO, true };
 #endif
@@ -58,7 +65,7 @@ static size_t calcHashMask(size_t numEntries)
     return result;
 }
 
-size_t TransTable::normalizeNumEntries(size_t numEntries)
+size_t TransTable::normalizeNumBuckets(size_t numEntries)
 {
     int shiftCount = 0;
 
@@ -67,10 +74,6 @@ size_t TransTable::normalizeNumEntries(size_t numEntries)
         return 0;
     }
 
-    // numEntries should be a mult of kNumHashLocks
-    numEntries /= kNumHashLocks;
-    numEntries *= kNumHashLocks;
-
 #if 0    
     // A version that forces 'numEntries' to be a power of 2.
     // Strip off low '1' bits as long as doing so would not make 'numEntries'
@@ -105,9 +108,9 @@ static int64 constrainSize(int64 size)
 
 int64 TransTable::normalizeSize(int64 size)
 {
-    int64 result = constrainSize(size) / sizeof(HashPositionT); // calc numEntries
-    result = normalizeNumEntries(result);
-    return result * sizeof(HashPositionT);
+    int64 result = constrainSize(size) / sizeof(HashBucketT); // calc numBuckets
+    result = normalizeNumBuckets(result);
+    return result * sizeof(HashBucketT);
 }
 
 // Returns the maximum *possible* size you could configure the transposition
@@ -139,35 +142,226 @@ size_t TransTable::sanitizeSize(int64 size)
         MIN(normalizeSize(size), normalizeSize(MaxSize()));
 }
 
-void TransTable::resetEntries()
+// Scores are stored in 16 bits.  Detected wins and losses keep their exact
+//  distance from Eval::Win (or Eval::Loss); everything else is clamped to
+//  +/- kMaxPackedScore, which no real evaluation comes near.
+static const int kPackedWin = INT16_MAX;
+static const int kPackedWinThreshold =
+    kPackedWin - (Eval::Win - Eval::WinThreshold);
+static const int kMaxPackedScore = 32000;
+static_assert(kMaxPackedScore < kPackedWinThreshold, "kMaxPackedScore broken");
+
+static inline uint16 packScore(int score)
+{
+    return uint16(int16(
+        score >= Eval::WinThreshold ? score - Eval::Win + kPackedWin :
+        score <= Eval::LossThreshold ? score - Eval::Loss - kPackedWin :
+        MAX(MIN(score, kMaxPackedScore), -kMaxPackedScore)));
+}
+
+static inline int unpackScore(uint16 packed)
+{
+    int score = int16(packed);
+    return
+        score >= kPackedWinThreshold ? score - kPackedWin + Eval::Win :
+        score <= -kPackedWinThreshold ? score + kPackedWin + Eval::Loss :
+        score;
+}
+
+// Moves are stored as src:6 dst:6 promote:3.  (Castling 'src' and 'dst' are
+//  small, so they fit as well.)  MoveNone gets a pattern no real move has.
+//  That leaves the top bit for HashEntryT::pathDependent.
+static const uint16 kPackedMoveNone = 0x7fff;
+static const uint16 kPackedPathDependent = 0x8000;
+
+static inline uint16 packMove(MoveT move)
 {
-    HashPositionT newHashEntry;
+    return move == MoveNone ? kPackedMoveNone :
+        uint16(move.src | (move.dst << 6) | (uint16(move.promote) << 12));
+}
 
-    memset(&newHashEntry, 0, sizeof(newHashEntry));
-    newHashEntry.depth = HASH_NOENTRY;
-    newHashEntry.move = MoveNone;
+static inline MoveT unpackMove(uint16 packed)
+{
+    packed &= ~kPackedPathDependent;
+    return packed == kPackedMoveNone ? MoveNone :
+        MoveT(packed & 0x3f, (packed >> 6) & 0x3f,
+              PieceType((packed >> 12) & 0x7), FLAG);
+}
 
-    std::fill(hash.begin(), hash.end(), newHashEntry);
+// Layout (from the low bits): eval low bound:16, eval high bound:16, move:15,
+//  pathDependent:1, depth:8, generation:8.
+uint64 TransTable::packEntry(const HashEntryT &entry)
+{
+    return
+        uint64(packScore(entry.eval.LowBound())) |
+        (uint64(packScore(entry.eval.HighBound())) << 16) |
+        (uint64(packMove(entry.move) |
+                (entry.pathDependent ? kPackedPathDependent : 0)) << 32) |
+        (uint64(uint8(entry.depth)) << 48) |
+        (uint64(entry.generation) << 56);
 }
 
-// (re-)initialize everything calcEntry() needs to work properly.
-void TransTable::prepCalcEntry()
+void TransTable::unpackEntry(uint64 zobrist, uint64 data, HashEntryT *entry)
 {
-    int numEntries = hash.size();
+    entry->zobrist = zobrist;
+    entry->eval.Set(unpackScore(uint16(data)), unpackScore(uint16(data >> 16)));
+    entry->move = unpackMove(uint16(data >> 32));
+    entry->pathDependent = uint16(data >> 32) & kPackedPathDependent;
+    entry->depth = int8(uint8(data >> 48));
+    entry->generation = uint8(data >> 56);
+}
+
+void TransTable::storeEntry(HashPositionT &hp, const HashEntryT &entry)
+{
+    uint64 data = packEntry(entry);
+    hp.data.store(data, std::memory_order_relaxed);
+    hp.check.store(entry.zobrist ^ data, std::memory_order_relaxed);
+}
+
+TransTable::HashEntryT TransTable::emptyEntry()
+{
+    HashEntryT entry;
+
+    memset(&entry, 0, sizeof(entry));
+    entry.depth = HASH_NOENTRY;
+    entry.move = MoveNone;
+    return entry;
+}
+
+void TransTable::resetEntries(TableT &table, int numThreads)
+{
+    HashEntryT newHashEntry = emptyEntry();
+
+    // Clearing a big table takes long enough that it is worth splitting up.
+    //  Each thread gets a contiguous slice of buckets.
+    numThreads = MAX(1, MIN(size_t(numThreads), table.numBuckets));
+    auto clearSlice = [&table, &newHashEntry, numThreads](int slice)
+    {
+        size_t start = table.numBuckets * slice / numThreads;
+        size_t end = table.numBuckets * (slice + 1) / numThreads;
+        for (size_t i = start; i < end; i++)
+        {
+            for (int j = 0; j < kBucketEntries; j++)
+                storeEntry(table.buckets[i].entries[j], newHashEntry);
+        }
+    };
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < numThreads; i++)
+        helpers.emplace_back(clearSlice, i);
+    clearSlice(0);
+    for (auto &helper : helpers)
+        helper.join();
+}
+
+// (re-)initialize everything calcBucket() needs to work properly.
+void TransTable::prepCalcEntry(TableT &table)
+{
+    size_t numEntries = table.numBuckets;
     int numLeadingZeros = calcNumLeadingZeros(numEntries);
 
-    hashMask = calcHashMask(numEntries);
-    shiftedNumEntries = numEntries >> numLeadingZeros;
-    shiftCount = 32 - numLeadingZeros;
+    table.hashMask = calcHashMask(numEntries);
+    table.shiftedNumEntries = numEntries >> numLeadingZeros;
+    table.shiftCount = 32 - numLeadingZeros;
+}
+
+void TransTable::freeTable(TableT &table)
+{
+    SystemFreeLarge(table.buckets, table.mapSize);
+    table.buckets = nullptr;
+    table.numBuckets = 0;
+    table.size = table.mapSize = table.pageSize = 0;
+    prepCalcEntry(table);
+}
+
+void TransTable::allocTable(TableT &table, size_t newSize)
+{
+    // Freeing first since I'd hate to have the new memory allocated at the
+    //  same time as the old memory (and there is no need to preserve the old
+    //  memory).
+    freeTable(table);
+    if (newSize)
+    {
+        table.buckets = (HashBucketT *)
+            SystemAllocLarge(newSize, &table.mapSize, &table.pageSize);
+        if (table.buckets == nullptr)
+        {
+            LOG_EMERG("Failed to allocate transposition table "
+                      "(%zu bytes)\n", newSize);
+            exit(0);
+        }
+        // The allocation is rounded up to whole pages; we might as well
+        //  use all of them.
+        table.size = normalizeSize(table.mapSize);
+        LogPrint(eLogNormal, "%s: %zu bytes (%zu entries), %zu kB pages\n",
+                 __func__, table.size, table.size / sizeof(HashPositionT),
+                 table.pageSize / 1024);
+    }
+    table.numBuckets = table.size / sizeof(HashBucketT);
+    prepCalcEntry(table);
+}
+
+TransTable::TableT &TransTable::spareTable()
+{
+    return tables[current.load(std::memory_order_relaxed) == &tables[0]];
+}
+
+std::atomic<uint32> TransTable::nextQuiesceEpoch(1);
+
+TransTable::QuiesceTableT::QuiesceTableT() : epoch(0)
+{
+    // Leave (at least) half of the L2 cache for everything else.
+    size_t numEntries = 1;
+    while (numEntries * 2 * sizeof(HashPositionT) <= SystemL2CacheSize() / 2)
+        numEntries *= 2;
+    entries = std::vector<HashPositionT>(numEntries);
+    mask = numEntries - 1;
+}
+
+TransTable::QuiesceTableT &TransTable::quiesceTable() const
+{
+    static thread_local QuiesceTableT table;
+
+    if (table.epoch != quiesceEpoch)
+    {
+        HashEntryT newHashEntry = emptyEntry();
+        for (HashPositionT &hp : table.entries)
+            storeEntry(hp, newHashEntry);
+        table.epoch = quiesceEpoch;
+    }
+    return table;
+}
+
+void TransTable::newQuiesceEpoch()
+{
+    quiesceEpoch = nextQuiesceEpoch++;
+}
+
+void TransTable::SetMinDepth(int depth)
+{
+    minDepth.store(depth, std::memory_order_relaxed);
 }
 
 // Initialize the global transposition table to size 'size'.
 TransTable::TransTable()
 {
-    // 'locks' should already be initialized.
-    size = 0;
+    for (TableT &table : tables)
+    {
+        table = TableT();
+        prepCalcEntry(table);
+    }
+    current = &tables[0];
     nextSize = normalizeSize(DefaultSize());
-    prepCalcEntry();
+    allocSize = 0;
+    ready = true;
+    resizing = false;
+    minDepth = 0;
+    newQuiesceEpoch();
+}
+
+TransTable::~TransTable()
+{
+    finishBackgroundWork();
+    freeTable(*current);
 }
 
 // Sets desired size of the transposition table.  Does not take effect until
@@ -180,19 +374,122 @@ void TransTable::SetDesiredSize(int64 sizeInBytes)
 // Clear the global transposition table.
 void TransTable::Reset()
 {
-    if (nextSize != size)
+    ResetAsync(SystemTotalProcessors());
+    WaitUntilReady();
+}
+
+void TransTable::ResetAsync(int numThreads)
+{
+    finishBackgroundWork(); // (only one reset or resize at a time)
+    ready = false;
+    newQuiesceEpoch();
+    // ('nextSize' might change in the meantime, so pass it along.)
+    resetThread = std::thread(&TransTable::reset, this, nextSize, numThreads);
+}
+
+void TransTable::ResizeAsync(int numThreads)
+{
+    finishBackgroundWork(); // (only one reset or resize at a time)
+    if (nextSize == allocSize)
+        return;
+    resizing = true;
+    resetThread = std::thread(&TransTable::resize, this, nextSize, numThreads);
+}
+
+void TransTable::WaitUntilReady()
+{
+    // The old table is perfectly usable while a resize is running.
+    if (!resizing.load(std::memory_order_acquire))
+        finishBackgroundWork();
+}
+
+void TransTable::finishBackgroundWork()
+{
+    if (resetThread.joinable())
+        resetThread.join();
+    // Any table a resize replaced might have still been in use until now.
+    freeTable(spareTable());
+}
+
+void TransTable::reset(size_t newSize, int numThreads)
+{
+    TableT &table = *current.load(std::memory_order_relaxed);
+
+    if (newSize != allocSize)
     {
-        // Resizing to 0 first since I'd hate to have the new memory allocated
-        //  at the same time as the old memory (and there is no need to preserve
-        //  the old memory).
-        hash.resize(0);
-        hash.shrink_to_fit();
-        hash.resize(nextSize / sizeof(HashPositionT));
-        size = nextSize;
-        prepCalcEntry();
+        allocSize = newSize;
+        allocTable(table, newSize);
     }
 
-    resetEntries();
+    resetEntries(table, numThreads);
+    ready.store(true, std::memory_order_release);
+}
+
+void TransTable::resize(size_t newSize, int numThreads)
+{
+    const TableT &oldTable = *current.load(std::memory_order_relaxed);
+    TableT &newTable = spareTable();
+
+    allocTable(newTable, newSize);
+    resetEntries(newTable, numThreads);
+
+    // Copy the old entries over.  Each thread reads a contiguous slice of the
+    //  old buckets, but the entries land all over the new table, so threads
+    //  may race on a bucket there.  Like in a search, that only costs an
+    //  entry.
+    numThreads = MAX(1, MIN(size_t(numThreads), oldTable.numBuckets));
+    std::vector<size_t> numCopied(numThreads, 0);
+    auto copySlice = [&oldTable, &newTable, &numCopied, numThreads](int slice)
+    {
+        size_t start = oldTable.numBuckets * slice / numThreads;
+        size_t end = oldTable.numBuckets * (slice + 1) / numThreads;
+        HashEntryT entry, victim;
+
+        for (size_t i = start; i < end; i++)
+        {
+            for (int j = 0; j < kBucketEntries; j++)
+            {
+                const HashPositionT &hp = oldTable.buckets[i].entries[j];
+                uint64 data = hp.data.load(std::memory_order_relaxed);
+                unpackEntry(hp.check.load(std::memory_order_relaxed) ^ data,
+                            data, &entry);
+                if (entry.depth == HASH_NOENTRY)
+                    continue;
+
+                // If the new table is smaller, this keeps the deepest
+                //  entries (much like ConditionalUpdate() would).
+                HashPositionT &dest =
+                    replacementEntry(newTable.buckets[calcBucket(newTable,
+                                                                 entry.zobrist)],
+                                     entry.zobrist, entry.generation, &victim);
+                if (victim.depth == HASH_NOENTRY ||
+                    victim.generation != entry.generation ||
+                    victim.depth < entry.depth)
+                {
+                    storeEntry(dest, entry);
+                    numCopied[slice]++;
+                }
+            }
+        }
+    };
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < numThreads; i++)
+        helpers.emplace_back(copySlice, i);
+    copySlice(0);
+    for (auto &helper : helpers)
+        helper.join();
+
+    size_t totalCopied = 0;
+    for (size_t copied : numCopied)
+        totalCopied += copied;
+    LogPrint(eLogNormal, "%s: %zu -> %zu bytes, copied %zu entries\n",
+             __func__, oldTable.size, newTable.size, totalCopied);
+
+    // Searches switch over on their next probe.  (The old table is freed by
+    //  the next finishBackgroundWork().)
+    allocSize = newSize;
+    current.store(&newTable, std::memory_order_release);
+    resizing.store(false, std::memory_order_release);
 }
 
 // Clears the transposition table, and sets its size to 'sizeInBytes'.
@@ -202,12 +499,166 @@ void TransTable::Reset(int64 sizeInBytes)
     Reset();
 }
 
+// A saved table is this header, padding upto kFileDataOffset (so the data
+//  can be mmap()ed on any page size we are likely to see), and then the raw
+//  buckets, in native byte order.
+static const char kFileMagic[8] = {'a', 'r', 'c', 't', 'i', 'c', 'T', 'T'};
+static const uint32 kFileVersion = 2; // bump when HashPositionT changes.
+static const int kFileDataOffset = 64 * 1024;
+static const uint64 kFileByteOrder = 0x0102030405060708ULL;
+
+struct TransTableFileHeaderT
+{
+    char magic[8];
+    uint32 version;
+    uint32 entrySize;
+    uint32 bucketSize;
+    uint32 pad;
+    uint64 byteOrder;
+    uint64 size; // in bytes, of the table data.
+    uint64 zobristSeed;
+    uint64 zobristCheck; // in case the zobrist generator itself changes
+};
+
+static void fillFileHeader(TransTableFileHeaderT *header, size_t size,
+                           size_t entrySize, size_t bucketSize)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, kFileMagic, sizeof(header->magic));
+    header->version = kFileVersion;
+    header->entrySize = entrySize;
+    header->bucketSize = bucketSize;
+    header->byteOrder = kFileByteOrder;
+    header->size = size;
+    header->zobristSeed = kZobristSeed;
+    header->zobristCheck = gPreCalc.zobrist.turn;
+}
+
+bool TransTable::Save(const std::string &fileName)
+{
+    finishBackgroundWork();
+    const TableT &table = *current.load(std::memory_order_relaxed);
+
+    if (fileName.empty())
+    {
+        LOG_NORMAL("%s: no file name given\n", __func__);
+        return false;
+    }
+
+    // Write to a temporary file first.  Besides not leaving a truncated file
+    //  around on failure, this keeps us from clobbering the file if it is
+    //  the one we Load()ed (and so, still have mapped).
+    std::string tmpName = fileName + ".tmp";
+    FILE *file = fopen(tmpName.c_str(), "wb");
+    if (file == nullptr)
+    {
+        LOG_NORMAL("%s: could not open '%s': %s\n",
+                   __func__, tmpName.c_str(), strerror(errno));
+        return false;
+    }
+
+    TransTableFileHeaderT header;
+    fillFileHeader(&header, table.size, sizeof(HashPositionT),
+                   sizeof(HashBucketT));
+    std::vector<char> padding(kFileDataOffset - sizeof(header), 0);
+
+    bool success =
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(padding.data(), padding.size(), 1, file) == 1 &&
+        (table.size == 0 || fwrite(table.buckets, table.size, 1, file) == 1);
+    success = !fclose(file) && success;
+    if (!success || rename(tmpName.c_str(), fileName.c_str()) != 0)
+    {
+        LOG_NORMAL("%s: could not write '%s': %s\n",
+                   __func__, fileName.c_str(), strerror(errno));
+        remove(tmpName.c_str());
+        return false;
+    }
+    LOG_NORMAL("%s: saved %zu bytes to '%s'\n",
+               __func__, table.size, fileName.c_str());
+    return true;
+}
+
+bool TransTable::Load(const std::string &fileName)
+{
+    finishBackgroundWork();
+
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        LOG_NORMAL("%s: could not open '%s': %s\n",
+                   __func__, fileName.c_str(), strerror(errno));
+        return false;
+    }
+
+    TransTableFileHeaderT header, expected;
+    struct stat st;
+    const char *problem =
+        pread(fd, &header, sizeof(header), 0) != sizeof(header) ?
+        "short or unreadable header" :
+        fstat(fd, &st) != 0 ? "could not stat" :
+        nullptr;
+    if (problem == nullptr)
+    {
+        fillFileHeader(&expected, header.size, sizeof(HashPositionT),
+                       sizeof(HashBucketT));
+        problem =
+            memcmp(header.magic, expected.magic, sizeof(header.magic)) ?
+            "not a transposition table file" :
+            header.version != expected.version ||
+            header.entrySize != expected.entrySize ||
+            header.bucketSize != expected.bucketSize ||
+            header.byteOrder != expected.byteOrder ?
+            "incompatible format" :
+            header.zobristSeed != expected.zobristSeed ||
+            header.zobristCheck != expected.zobristCheck ?
+            "different zobrist keys" :
+            // (We need the same bucket mapping as the saver.)
+            header.size == 0 || header.size > SIZE_MAX ||
+            uint64(normalizeSize(header.size)) != header.size ?
+            "bad table size" :
+            uint64(st.st_size) < kFileDataOffset + header.size ?
+            "truncated file" :
+            nullptr;
+    }
+
+    size_t newMapSize, newPageSize;
+    void *ptr = problem != nullptr ? nullptr :
+        SystemMapFile(fd, kFileDataOffset, header.size, &newMapSize,
+                      &newPageSize);
+    if (problem == nullptr && ptr == nullptr)
+        problem = strerror(errno);
+    close(fd); // (the mapping stays valid)
+
+    if (problem != nullptr)
+    {
+        LOG_NORMAL("%s: could not load '%s': %s\n",
+                   __func__, fileName.c_str(), problem);
+        return false;
+    }
+
+    TableT &table = *current.load(std::memory_order_relaxed);
+    freeTable(table);
+    table.buckets = (HashBucketT *) ptr;
+    table.mapSize = newMapSize;
+    table.pageSize = newPageSize;
+    // (So the next Reset() only reallocates if the desired size differs.)
+    allocSize = table.size = header.size;
+    table.numBuckets = table.size / sizeof(HashBucketT);
+    prepCalcEntry(table);
+    newQuiesceEpoch();
+
+    LOG_NORMAL("%s: loaded %zu bytes from '%s'\n",
+               __func__, table.size, fileName.c_str());
+    return true;
+}
+
 #define QUIESCING (searchDepth < 0)
 
 // If this shows up during profiling, we could put it in a private namespace.
 //  (I think that would preclude making it a HashPositionT member function,
 //   though.)
-bool TransTable::entryMatches(const HashPositionT &hp, uint64 zobrist,
+bool TransTable::entryMatches(const HashEntryT &hp, uint64 zobrist,
                               int alpha, int beta, int searchDepth)
 {
     return
@@ -228,14 +679,16 @@ bool TransTable::entryMatches(const HashPositionT &hp, uint64 zobrist,
          hp.eval.DetectedWinOrLoss());
 }
 
-size_t TransTable::calcEntry(uint64 zobrist) const
+size_t TransTable::calcBucket(const TableT &table, uint64 zobrist)
 {
+    // (In the below discussion, "entries" are really buckets.)
+
     // slow (although AMD is better than intel in this regard):
-    // return zobrist % hash.size();
+    // return zobrist % numBuckets;
 
     // fastest, but only does good distribution for tables of size
     // (numEntries * 2^n):
-    // return zobrist & (hash.size() - 1);
+    // return zobrist & (numBuckets - 1);
 
     // The basic idea here is that we want to map a number in the range
     // (0 .. 2^32) to a number in the range (0 .. numEntries - 1).  One way to
@@ -258,46 +711,49 @@ size_t TransTable::calcEntry(uint64 zobrist) const
     // bits.
 #if 1
     return
-        (((zobrist & 0xffffffffUL) * shiftedNumEntries) >> shiftCount) ^
-        ((zobrist >> 32) & hashMask);
+        (((zobrist & 0xffffffffUL) * table.shiftedNumEntries) >>
+         table.shiftCount) ^
+        ((zobrist >> 32) & table.hashMask);
 #endif
 }
 
 // Fills in 'hashEval' and 'hashMove' iff we had a successful hit.
-// Should only be called by IsHit(), which does some pre-checks.
+// Should only be called by IsHit(), which does some pre-checks.  'data' is
+//  what IsHit() read from 'hp'.
 bool TransTable::hitTest(Eval *hashEval, MoveT *hashMove, uint64 zobrist,
                          int searchDepth, uint16 basePly, int alpha, int beta,
-                         EngineStatsT *stats, size_t entry)
+                         HashStatsT *stats, HashPositionT &hp, uint64 data)
 {
-    HashPositionT &vHp = hash[entry];
-    int8 hashDepth;
-
-    Spinlock &lock = locks[entry & (kNumHashLocks - 1)];
-    lock.lock();
+    HashEntryT entry;
+    uint8 generation = basePly;
 
-    if (!entryMatches(vHp, zobrist, alpha, beta, searchDepth))
+    unpackEntry(zobrist, data, &entry);
+    if (entry.pathDependent)
     {
-        lock.unlock();
+        stats->pathDependent++;
         return false;
     }
+    if (!entryMatches(entry, zobrist, alpha, beta, searchDepth))
+        return false;
 
     // re-record items in the hit hash position to "reinforce" it
     // against future removal:
-    // 1) base ply for this move.
-    if (vHp.basePly != basePly)
-    {
-        stats->hashWroteNew++;
-        vHp.basePly = basePly;
-    }
+    // 1) generation (base ply) for this move.
     // 2) search depth (in case of checkmate, it might go up.  Not
     //    proven to be better.)
-    hashDepth = MAX(vHp.depth, searchDepth);
-    vHp.depth = hashDepth;
-    stats->hashHitGood++;
-    *hashEval = vHp.eval;
-    *hashMove = vHp.move;
-
-    lock.unlock();
+    // We only write when something actually changed, so that hits do not
+    //  dirty cache lines other threads are reading.  If another thread
+    //  wrote this entry in the meantime, one of the two writes is lost (or
+    //  the entry tears and reads as a miss), which is harmless.
+    if (entry.generation != generation || entry.depth < searchDepth)
+    {
+        entry.generation = generation;
+        entry.depth = MAX(entry.depth, searchDepth);
+        storeEntry(hp, entry);
+    }
+    stats->cutoffs[HashStatsT::DepthIndex(searchDepth)]++;
+    *hashEval = entry.eval;
+    *hashMove = entry.move;
 
 #ifdef ENABLE_DEBUG_LOGGING
     char tmpStr[MOVE_STRING_MAX];
@@ -305,7 +761,7 @@ bool TransTable::hitTest(Eval *hashEval, MoveT *hashMove, uint64 zobrist,
     LOG_DEBUG("hashHit alhbdmz: %d %s %d %d %s 0x%" PRIx64 "\n",
               alpha,
               hashEval->ToLogString(peStr),
-              beta, hashDepth,
+              beta, entry.depth,
               hashMove->ToString(tmpStr, &gMoveStyleTT, NULL),
               zobrist);
 #endif
@@ -315,59 +771,114 @@ bool TransTable::hitTest(Eval *hashEval, MoveT *hashMove, uint64 zobrist,
 
 void TransTable::Prefetch(uint64 zobrist) const
 {
-    if (Size())
+    // (Boards may make moves while a ResetAsync() is still running.)
+    if (ready.load(std::memory_order_acquire))
     {
-        __builtin_prefetch(&hash[calcEntry(zobrist)]);
+        const TableT &table = *current.load(std::memory_order_acquire);
+        if (table.size)
+            __builtin_prefetch(&table.buckets[calcBucket(table, zobrist)]);
+    }
+}
+
+TransTable::HashPositionT &
+TransTable::replacementEntry(HashBucketT &bucket, uint64 zobrist,
+                             uint8 generation, HashEntryT *entry)
+{
+    HashPositionT *entries = bucket.entries;
+    HashPositionT *victim = &entries[0];
+    int victimScore = INT_MAX;
+    uint64 victimData = 0;
+
+    for (int i = 0; i < kBucketEntries; i++)
+    {
+        uint64 data = entries[i].data.load(std::memory_order_relaxed);
+        uint64 key = entries[i].check.load(std::memory_order_relaxed) ^ data;
+        if (key == zobrist)
+        {
+            unpackEntry(key, data, entry);
+            return entries[i];
+        }
+
+        // Prefer throwing out the shallowest entry.  Entries that were not
+        //  touched by this search are cheaper still (and empty entries,
+        //  with a depth of HASH_NOENTRY, are cheapest of all).
+        int score = int8(uint8(data >> 48)) -
+            (uint8(data >> 56) != generation ? 256 : 0);
+        if (score < victimScore)
+        {
+            victim = &entries[i];
+            victimScore = score;
+            victimData = data;
+            entry->zobrist = key;
+        }
     }
+    unpackEntry(entry->zobrist, victimData, entry);
+    return *victim;
 }
 
 void TransTable::ConditionalUpdate(Eval eval, MoveT move, uint64 zobrist,
                                    int searchDepth, uint16 basePly,
-                                   EngineStatsT *stats)
+                                   bool pathDependent, HashStatsT *stats)
 {
-    if (!Size())
+    const TableT &table = *current.load(std::memory_order_acquire);
+    if (!table.size)
+        return; // (see IsHit())
+
+    HashEntryT entry;
+    uint8 generation = basePly;
+
+    if (QUIESCING)
+    {
+        // There is no point keeping the old entry: it is most likely for a
+        //  position we are done with.
+        entry.zobrist = zobrist;
+        entry.eval = eval;
+        entry.move = move;
+        entry.generation = generation;
+        entry.depth = searchDepth;
+        entry.pathDependent = pathDependent;
+        storeEntry(quiesceTable().Entry(zobrist), entry);
+    }
+    int shallowest = MinDepth();
+    if (shallowest >= 0 && searchDepth < shallowest)
         return;
-    
-    size_t entry = calcEntry(zobrist);
-    HashPositionT &vHp = hash[entry];
+
+    HashPositionT &hp =
+        replacementEntry(table.buckets[calcBucket(table, zobrist)], zobrist,
+                         generation, &entry);
 
     // Do we want to update the table?
     // (HASH_NOENTRY should always trigger here)
-    if (searchDepth > vHp.depth ||
+    if (searchDepth > entry.depth ||
+        // If this is not our position, it is already the least valuable
+        //  entry in the bucket, so only keep it if it is deeper.
+        (entry.zobrist != zobrist && searchDepth == entry.depth) ||
         // Replacing entries that came before this search is aggressive,
         // but it works better than a 'numPieces' comparison.  We use "!="
         // instead of "<" because we may move backwards in games as well
         // (undoing moves, or setting positions etc.)
-        vHp.basePly != basePly ||
+        entry.generation != generation ||
         // Otherwise, use the position that gives us as much info as
         // possible, and after that the most recently used (ie this move).
-        (searchDepth == vHp.depth &&
-         eval.Range() <= vHp.eval.Range()))
+        (searchDepth == entry.depth &&
+         eval.Range() <= entry.eval.Range()))
     {
-        // We only lock the hashtable once we know we want to do an update.
-        // This lets us do slightly lazier locking.
-
-        // Every single element of this structure (except 'pad') should
-        // always be updated, since:
-        // -- it is not blanked for a newgame
-        // -- the hash entry might have been overwritten in the meantime
-        // (by another thread, or at a different ply).
-        Spinlock &lock = locks[entry & (kNumHashLocks - 1)];
-        lock.lock();
-
-        vHp.zobrist = zobrist;
-        vHp.eval = eval;
-        vHp.move = move; // may be MoveNone
-
-        if (((volatile HashPositionT &)vHp).basePly != basePly)
-        {
-            stats->hashWroteNew++;
-            vHp.basePly = basePly;
-        }
-
-        vHp.depth = searchDepth;
-
-        lock.unlock();
+        HashStatsT::Write why =
+            entry.depth == HASH_NOENTRY ? HashStatsT::Write::Empty :
+            entry.zobrist == zobrist ? HashStatsT::Write::Same :
+            entry.generation != generation ? HashStatsT::Write::Stale :
+            HashStatsT::Write::Shallower;
+        stats->writes[int(why)]++;
+
+        // Every single element of this structure should always be updated,
+        // since it is not blanked for a newgame.
+        entry.zobrist = zobrist;
+        entry.eval = eval;
+        entry.move = move; // may be MoveNone
+        entry.generation = generation;
+        entry.depth = searchDepth;
+        entry.pathDependent = pathDependent;
+        storeEntry(hp, entry);
 
 #ifdef ENABLE_DEBUG_LOGGING
         char tmpStr[MOVE_STRING_MAX];
@@ -380,4 +891,34 @@ void TransTable::ConditionalUpdate(Eval eval, MoveT move, uint64 zobrist,
                   zobrist);
 #endif
     }
+    else
+    {
+        stats->writes[int(HashStatsT::Write::Skipped)]++;
+    }
+}
+
+void TransTable::SampleOccupancy(uint16 generation, HashStatsT *stats) const
+{
+    const TableT &table = *current.load(std::memory_order_acquire);
+    size_t numBuckets =
+        MIN(table.numBuckets, size_t(kSampleEntries / kBucketEntries));
+
+    stats->sampled = numBuckets * kBucketEntries;
+    for (int i = 0; i < HashStatsT::kNumAges; i++)
+        stats->ages[i] = 0;
+
+    for (size_t i = 0; i < numBuckets; i++)
+    {
+        for (int j = 0; j < kBucketEntries; j++)
+        {
+            const HashPositionT &hp = table.buckets[i].entries[j];
+            uint64 data = hp.data.load(std::memory_order_relaxed);
+            if (int8(uint8(data >> 48)) == HASH_NOENTRY)
+                continue;
+            // (Generations wrap, and we might also have moved backwards, so
+            //  this is only a guess.)
+            uint8 age = uint8(generation) - uint8(data >> 56);
+            stats->ages[MIN(int(age), HashStatsT::kNumAges - 1)]++;
+        }
+    }
 }
@@ -14,9 +14,12 @@
 #ifndef TRANSTABLE_H
 #define TRANSTABLE_H
 
+#include <atomic>
+#include <string>
+#include <thread>
 #include <vector>
 
-#include "aSpinlock.h"
+#include "aSystem.h" // kCacheLineSize
 #include "aTypes.h"
 #include "EngineTypes.h"
 #include "Eval.h"
@@ -27,13 +30,39 @@ class TransTable
 {
 public:
     TransTable();
+    ~TransTable();
 
     // Clears the transposition table.  Does not change its size, unless
-    //  'SetDesiredSize()' has been called in the meantime.
+    //  'SetDesiredSize()' has been called in the meantime.  (The clear is
+    //  split across all processors.)
     void Reset();
     // Clears the transposition table, and sets its size to 'sizeInBytes'.
     void Reset(int64 sizeInBytes);
 
+    // Like Reset(void), but returns immediately; (re-)allocating and clearing
+    //  the table happen in the background, split across 'numThreads' threads.
+    //  Nothing but Prefetch() may touch the table until WaitUntilReady() has
+    //  been called.
+    void ResetAsync(int numThreads);
+    // Changes the table's size to what 'SetDesiredSize()' last asked for,
+    //  keeping (as many as will fit of) its entries.  This also returns
+    //  immediately, but unlike ResetAsync(), the table stays usable at its old
+    //  size while the new one is built from it in the background (split across
+    //  'numThreads' threads); the new one takes over once it is complete.
+    //  (Entries written to the old table after they were copied are lost.)
+    void ResizeAsync(int numThreads);
+    // Blocks until any ResetAsync() in progress is finished.  Does not wait for
+    //  a ResizeAsync(), but frees the table a finished one replaced, so must
+    //  only be called when nothing is searching.
+    void WaitUntilReady();
+
+    // Saves the table to 'fileName' (along with what we need to tell if a
+    //  later run can use it), or loads it from there.  Loading maps the file
+    //  directly (copy-on-write) as the table, replacing both its contents and
+    //  its size.  Both log (and return false) on failure.
+    bool Save(const std::string &fileName);
+    bool Load(const std::string &fileName);
+
     // Sets desired size of the transposition table.  Does not take effect until
     //  the next 'Reset(void)' call.  (used for lazy initialization)
     void SetDesiredSize(int64 sizeInBytes);
@@ -47,6 +76,10 @@ public:
     //  hashing strategy).
     size_t Size() const;
 
+    // Returns the size (in bytes) of the memory pages that (we expect) back
+    //  the transposition table, or 0 if it has no memory yet.
+    size_t PageSize() const;
+
     // Returns the default size (in bytes) of the transposition table (ie, what
     //  size is used if you Reset(void) the table at startup).
     static size_t DefaultSize();
@@ -59,95 +92,250 @@ public:
     // Pre-cache a transtable entry for later use.
     void Prefetch(uint64 zobrist) const;
 
+    // Fills in the occupancy sample in 'stats' (see HashStatsT) from the first
+    //  kSampleEntries entries of the table.  'generation' is what the current
+    //  search passes as 'basePly'.
+    static const int kSampleEntries = 1000;
+    void SampleOccupancy(uint16 generation, HashStatsT *stats) const;
+
+    // Sets the shallowest 'searchDepth' whose results ConditionalUpdate()
+    //  stores in the table proper.  Quiescing positions (searchDepth < 0) are
+    //  always stored in a small table private to the searching thread, which
+    //  IsHit() checks first; any negative 'depth' stores them here as well.
+    //  (While the table has a size of 0, neither is used.)
+    void SetMinDepth(int depth);
+    int MinDepth() const;
+
     // Fills in 'hashEval' and 'hashMove' iff we had a successful hit.
     // (Does alter the hash table as a side effect, so cannot be const)
+    // 'hashMove' does not have its 'chk' filled in (it is FLAG); use
+    //  MoveList::SearchSrcDstPromote() or SearchPv::Sanitize() to recover
+    //  it before making the move.
+    // Both this and ConditionalUpdate() count what they do in 'stats'.
     bool IsHit(Eval *hashEval, MoveT *hashMove, uint64 zobrist,
                int searchDepth, uint16 basePly, int alpha, int beta,
-               EngineStatsT *stats);
+               HashStatsT *stats);
 
     // (Maybe) update the transposition table with the new position.  The
     //  table code itself decides whether it is optimal to actually do the
-    //  update.
+    //  update.  'pathDependent' says 'eval' depended on how we got to the
+    //  position (through draw detection), so IsHit() must not use it later.
     void ConditionalUpdate(Eval eval, MoveT move, uint64 zobrist,
-                           int searchDepth, uint16 basePly,
-                           EngineStatsT *stats);
+                           int searchDepth, uint16 basePly, bool pathDependent,
+                           HashStatsT *stats);
 
 private:
-    struct HashPositionT
+    // The (unpacked) contents of a transposition table entry.
+    struct HashEntryT
     {
         uint64 zobrist;
         Eval eval;
-        MoveT move;     // stores preferred move for this position.
-        uint16 basePly; // lets us evaluate if this entry is 'too old'.
-        int8 depth;     // needs to be plys from quiescing, due to incremental
-                        //  search.
-        int8 pad;       // unused
+        MoveT move;       // stores preferred move for this position.  (Its
+                          //  'chk' is not stored, and reads back as FLAG.)
+        uint8 generation; // the low bits of the basePly this entry was last
+                          //  used at; lets us evaluate if it is 'too old'.
+        int8 depth;       // needs to be plys from quiescing, due to
+                          //  incremental search.
+        bool pathDependent; // see ConditionalUpdate(); IsHit() ignores
+                            //  these entries.
     };
-    static_assert(sizeof(HashPositionT) == 24, "HashPositionT is broken");
-    
-    static const int kNumHashLocks = 1024;
-    arctic::Spinlock locks[kNumHashLocks];
-
-    // The below entries are size_t because it does not make sense to try to
-    //  force a 64-bit size on a 32-bit platform.  (realloc() would fail)  I
-    //  would use 'long' but that is defined to 32 bits on win64.
-    // size_t numEntries; same as hash.Size()
-    size_t size; // in bytes, current size of hash table
+
+    // How an entry is actually stored.  All of HashEntryT (but the zobrist)
+    //  is packed into 'data' (see packEntry()): the eval bounds as 16-bit
+    //  scores, the move and 'pathDependent' in 16 bits, and the generation
+    //  and depth as a byte each.
+    // There is no locking: the key is stored XORed with the data, so an
+    //  entry torn by concurrent writers fails to verify and just reads as a
+    //  miss.  Both words are accessed with relaxed atomics.
+    struct HashPositionT
+    {
+        std::atomic<uint64> check; // zobrist ^ data
+        std::atomic<uint64> data;
+    };
+    static_assert(sizeof(HashPositionT) == 16, "HashPositionT is broken");
+
+    // Entries are grouped into cache-line-sized (and aligned) buckets.  A
+    //  position may be stored in any entry of its bucket, so probing costs a
+    //  single cache miss, and a deep entry does not have to be thrown out
+    //  just because a shallower one collides with it.
+    static const int kBucketEntries = kCacheLineSize / sizeof(HashPositionT);
+    struct alignas(kCacheLineSize) HashBucketT
+    {
+        HashPositionT entries[kBucketEntries];
+    };
+    static_assert(sizeof(HashBucketT) == kCacheLineSize,
+                  "HashBucketT is broken");
+
+    // Everything about one allocated table.  There are two, so that
+    //  ResizeAsync() can build a new table while the old one is in use.
+    struct TableT
+    {
+        // The below entries are size_t because it does not make sense to try
+        //  to force a 64-bit size on a 32-bit platform.  (realloc() would
+        //  fail)  I would use 'long' but that is defined to 32 bits on win64.
+        // size_t numEntries; same as numBuckets * kBucketEntries
+        size_t size; // in bytes, current size of hash table
+        size_t mapSize; // in bytes, what we actually allocated (>= 'size')
+        size_t pageSize;
+        HashBucketT *buckets; // the transposition table proper.
+        size_t numBuckets;
+
+        // Support for quick(er) hash entry calculation (all initialized by
+        //  prepCalcEntry()):
+        size_t hashMask; // could be 'int' if needed
+        size_t shiftedNumEntries; // could be 'int' if needed
+        int shiftCount;
+    };
+    TableT tables[2];
+    std::atomic<TableT *> current; // the one of 'tables' that is in use
     size_t nextSize; // in bytes, takes effect on next reset
-    std::vector<HashPositionT> hash; // the transposition table proper.
+    size_t allocSize; // in bytes, what 'nextSize' was when we last allocated
+
+    TableT &spareTable();
+
+    // (re-)initialize everything calcBucket() needs to work properly.
+    static void prepCalcEntry(TableT &table);
 
-    // Support for quick(er) hash entry calculation (all initialized by
-    //  prepCalcEntry()):
-    size_t hashMask; // could be 'int' if needed
-    size_t shiftedNumEntries; // could be 'int' if needed
-    int shiftCount;
+    static size_t calcBucket(const TableT &table, uint64 zobrist);
 
-    // (re-)initialize everything calcEntry() needs to work properly.
-    void prepCalcEntry();
+    // (Re-)allocates 'table' to 'newSize' bytes (or frees it, for 0).
+    static void allocTable(TableT &table, size_t newSize);
+    static void freeTable(TableT &table);
 
-    size_t calcEntry(uint64 zobrist) const;
+    // Does the work for ResetAsync() and ResizeAsync().
+    void reset(size_t newSize, int numThreads);
+    static void resetEntries(TableT &table, int numThreads);
+    void resize(size_t newSize, int numThreads);
 
-    void resetEntries();
+    // Joins 'resetThread' (if needed), and frees any table a resize replaced.
+    void finishBackgroundWork();
+
+    std::thread resetThread; // joinable while a ResetAsync() or ResizeAsync()
+                             //  might be running
+    std::atomic<bool> ready; // false while a ResetAsync() is running
+    std::atomic<bool> resizing; // true while a ResizeAsync() is running
+
+    std::atomic<int> minDepth; // see SetMinDepth()
+
+    // Quiescing nodes far outnumber the others, and are cheap to search
+    //  again, so rather than have them churn the main table (and evict deep
+    //  results), each thread keeps its own small table of them, sized to stay
+    //  in its L2 cache.  Entries are direct-mapped, and always replaced.
+    struct QuiesceTableT
+    {
+        QuiesceTableT();
+        HashPositionT &Entry(uint64 zobrist);
+        std::vector<HashPositionT> entries;
+        size_t mask;
+        uint32 epoch; // 'quiesceEpoch' of the table this was last cleared for
+    };
+    // Every (re)set of any TransTable gets a new, unique 'quiesceEpoch', so
+    //  that a thread's quiesce table can tell when it is out of date.
+    uint32 quiesceEpoch;
+    static std::atomic<uint32> nextQuiesceEpoch;
+    void newQuiesceEpoch();
+    // Returns: this thread's quiesce table (cleared first, if needed).
+    QuiesceTableT &quiesceTable() const;
 
     bool hitTest(Eval *hashEval, MoveT *hashMove, uint64 zobrist,
                  int searchDepth, uint16 basePly, int alpha, int beta,
-                 EngineStatsT *stats, size_t entry);
+                 HashStatsT *stats, HashPositionT &hp, uint64 data);
 
-    static size_t normalizeNumEntries(size_t numEntries);
+    // Returns: the entry in 'bucket' that 'zobrist' should be written to
+    //  (its current contents are copied to 'entry').
+    static HashPositionT &replacementEntry(HashBucketT &bucket, uint64 zobrist,
+                                           uint8 generation, HashEntryT *entry);
+
+    static HashEntryT emptyEntry();
+    static uint64 packEntry(const HashEntryT &entry);
+    static void unpackEntry(uint64 zobrist, uint64 data, HashEntryT *entry);
+    static void storeEntry(HashPositionT &hp, const HashEntryT &entry);
+
+    static size_t normalizeNumBuckets(size_t numBuckets);
     static int64 normalizeSize(int64 size);
     static size_t sanitizeSize(int64 size);
 
-    static bool entryMatches(const HashPositionT &hp, uint64 zobrist,
+    static bool entryMatches(const HashEntryT &hp, uint64 zobrist,
                              int alpha, int beta, int searchDepth);
 };
 
 inline size_t TransTable::Size() const
 {
-    return size;
+    return current.load(std::memory_order_acquire)->size;
+}
+
+inline size_t TransTable::PageSize() const
+{
+    return current.load(std::memory_order_acquire)->pageSize;
 }
 
 inline size_t TransTable::NumEntries() const
 {
-    return hash.size();
+    return current.load(std::memory_order_acquire)->numBuckets *
+        kBucketEntries;
+}
+
+inline int TransTable::MinDepth() const
+{
+    return minDepth.load(std::memory_order_relaxed);
+}
+
+inline TransTable::HashPositionT &
+TransTable::QuiesceTableT::Entry(uint64 zobrist)
+{
+    return entries[zobrist & mask];
 }
 
 inline bool TransTable::IsHit(Eval *hashEval, MoveT *hashMove, uint64 zobrist,
                               int searchDepth, uint16 basePly,
                               int alpha, int beta,
-                              EngineStatsT *stats)
+                              HashStatsT *stats)
 {
-    if (!Size())
+    // (A ResizeAsync() may swap in a new table at any time, so only look
+    //  once.)
+    const TableT &table = *current.load(std::memory_order_acquire);
+    // (A disabled table disables the quiesce table, too.  The tuner relies on
+    //  this, since it changes the evaluation between searches.)
+    if (!table.size)
         return false;
 
-    size_t entry = calcEntry(zobrist);
+    int depthIdx = HashStatsT::DepthIndex(searchDepth);
+    stats->probes[depthIdx]++;
+    bool found = false;
 
-    // Do an unlocked check.  Not threadsafe, but we will recheck in a safe
-    //  manner if we actually get a hit.
-    if (hash[entry].zobrist != zobrist)
-        return false;
+    if (searchDepth < 0)
+    {
+        HashPositionT &hp = quiesceTable().Entry(zobrist);
+        uint64 data = hp.data.load(std::memory_order_relaxed);
+        if ((hp.check.load(std::memory_order_relaxed) ^ data) == zobrist)
+        {
+            found = true;
+            stats->hits[depthIdx]++;
+            if (hitTest(hashEval, hashMove, zobrist, searchDepth, basePly,
+                        alpha, beta, stats, hp, data))
+            {
+                return true;
+            }
+        }
+        // (A deeper result, or one with better bounds, might still be in the
+        //  main table.)
+    }
 
-    return hitTest(hashEval, hashMove, zobrist, searchDepth, basePly,
-                   alpha, beta, stats, entry);
+    HashPositionT *entries = table.buckets[calcBucket(table, zobrist)].entries;
+
+    for (int i = 0; i < kBucketEntries; i++)
+    {
+        uint64 data = entries[i].data.load(std::memory_order_relaxed);
+        if ((entries[i].check.load(std::memory_order_relaxed) ^ data) ==
+            zobrist)
+        {
+            if (!found)
+                stats->hits[depthIdx]++;
+            return hitTest(hashEval, hashMove, zobrist, searchDepth, basePly,
+                           alpha, beta, stats, entries[i], data);
+        }
+    }
+    return false;
 }
 
 
@@ -12,7 +12,10 @@
 //--------------------------------------------------------------------------
 
 #include <assert.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>     // mmap(2), madvise(2)
 #include <sys/stat.h>     // mkdir(2)
 #include <sys/time.h>     // get+setrlimit(2)
 #include <sys/resource.h>
@@ -66,6 +69,119 @@ int SystemTotalProcessors()
     return std::thread::hardware_concurrency();
 }
 
+size_t SystemL2CacheSize()
+{
+    long size = -1;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    // (sysconf() returns 0 when the value is unknown.)
+    return size > 0 ? size_t(size) : 256 * 1024;
+}
+
+// Returns: the first line of file 'path' (without the newline), or "" if it
+//  could not be read.
+static std::string readFirstLine(const char *path)
+{
+    char line[256] = "";
+    FILE *file = fopen(path, "r");
+
+    if (file == nullptr)
+        return "";
+    if (fgets(line, sizeof(line), file) == nullptr)
+        line[0] = '\0';
+    fclose(file);
+    line[strcspn(line, "\n")] = '\0';
+    return line;
+}
+
+static size_t roundUp(size_t size, size_t multiple)
+{
+    return (size + multiple - 1) / multiple * multiple;
+}
+
+void *SystemAllocLarge(size_t size, size_t *mapSize, size_t *pageSize)
+{
+    size_t basePageSize = sysconf(_SC_PAGESIZE);
+    size_t hugePageSize = atoll(
+        readFirstLine("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size")
+        .c_str());
+    void *ptr;
+
+    if (hugePageSize <= basePageSize)
+        hugePageSize = 2 * 1024 * 1024; // (a good guess, at least for x86)
+
+    if (size < hugePageSize)
+    {
+        // Not worth wasting a huge page on.
+        *mapSize = roundUp(size, basePageSize);
+        *pageSize = basePageSize;
+        ptr = mmap(nullptr, *mapSize, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    *mapSize = roundUp(size, hugePageSize);
+
+#ifdef MAP_HUGETLB
+    // Explicit huge pages are best, but only work if the admin reserved
+    //  some (see /proc/sys/vm/nr_hugepages).
+    ptr = mmap(nullptr, *mapSize, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED)
+    {
+        *pageSize = hugePageSize;
+        return ptr;
+    }
+#endif
+
+    // Otherwise, fall back to regular pages, aligned so that transparent huge
+    //  pages can back them.  (We over-allocate and trim off the excess.)
+    ptr = mmap(nullptr, *mapSize + hugePageSize, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return nullptr;
+    char *start = (char *) ptr;
+    char *alignedStart = (char *) roundUp((uintptr_t) start, hugePageSize);
+    char *end = start + *mapSize + hugePageSize;
+    if (alignedStart != start)
+        munmap(start, alignedStart - start);
+    if (alignedStart + *mapSize != end)
+        munmap(alignedStart + *mapSize, end - (alignedStart + *mapSize));
+
+    *pageSize = basePageSize;
+#ifdef MADV_HUGEPAGE
+    std::string thpMode =
+        readFirstLine("/sys/kernel/mm/transparent_hugepage/enabled");
+    if (!madvise(alignedStart, *mapSize, MADV_HUGEPAGE) &&
+        thpMode.find("[never]") == std::string::npos)
+    {
+        *pageSize = hugePageSize;
+    }
+#endif
+    return alignedStart;
+}
+
+void SystemFreeLarge(void *ptr, size_t mapSize)
+{
+    if (ptr != nullptr)
+        munmap(ptr, mapSize);
+}
+
+void *SystemMapFile(int fd, int64 offset, size_t size, size_t *mapSize,
+                    size_t *pageSize)
+{
+    *pageSize = sysconf(_SC_PAGESIZE);
+    *mapSize = roundUp(size, *pageSize);
+    void *ptr = mmap(nullptr, *mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                     fd, offset);
+    if (ptr == MAP_FAILED)
+        return nullptr;
+    // We are likely to touch all of it (in random order), so start reading.
+    madvise(ptr, *mapSize, MADV_WILLNEED);
+    return ptr;
+}
+
 std::string SystemAppDirectory()
 {
     char *homePath = getenv("HOME");
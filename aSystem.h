@@ -19,9 +19,31 @@
 #include <string>
 #include "aTypes.h" // int64 etc.
 
+// Size of a CPU cache line, in bytes.  (This is a guess, but a good one for
+//  any platform we are likely to run on.)  Data that is written by one thread
+//  and frequently read by others should sit on its own cache line(s).
+const int kCacheLineSize = 64;
+
 void SystemEnableCoreFile();
 int64 SystemTotalMemory();
 int SystemTotalProcessors();
+// Returns the size (in bytes) of a (per-core) level 2 cache, or a guess if we
+//  cannot find out.
+size_t SystemL2CacheSize();
+
+// Allocates 'size' bytes of zeroed, page-aligned memory for a big table,
+//  backed by huge pages when we can get them (to cut down on TLB misses).
+//  Returns nullptr on failure.  Otherwise, '*mapSize' is the number of bytes
+//  actually allocated (at least 'size', and a multiple of '*pageSize', the
+//  page size we expect backs the memory); pass it to SystemFreeLarge().
+void *SystemAllocLarge(size_t size, size_t *mapSize, size_t *pageSize);
+void SystemFreeLarge(void *ptr, size_t mapSize);
+// Maps 'size' bytes of open file 'fd', starting at 'offset' (a multiple of
+//  the page size), copy-on-write: changes are never written back to the
+//  file.  Returns nullptr on failure; otherwise release the memory with
+//  SystemFreeLarge(ptr, *mapSize).
+void *SystemMapFile(int fd, int64 offset, size_t size, size_t *mapSize,
+                    size_t *pageSize);
 
 // Return directory we should use to write logs and (in future?) other config.
 std::string SystemAppDirectory();
@@ -19,9 +19,12 @@
 #include "Board.h"
 #include "comp.h"
 #include "Eval.h"
+#include "Evaluate.h"
 #include "gPreCalc.h"
 #include "HistoryWindow.h"
 #include "log.h"
+#include "Material.h"
+#include "Pawns.h"
 #include "ref.h"
 #include "Thinker.h"
 #include "uiUtil.h"
@@ -76,9 +79,14 @@
 #define HASH_MISS 1
 #define HASH_HIT 0
 
+// Number of nodes each thinker searches between checks of its cmdqueue (and
+//  of the node limit).  Must be a power of 2.  This is small enough that we
+//  still respond to a "move now" within a millisecond or so, but large enough
+//  that polling costs nothing measurable.
+static const int kPollNodes = 1024;
+
 // Forward declarations.
-static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
-                    int *hashHitOnly);
+static Eval minimax(Thinker *th, int alpha, int beta, int *hashHitOnly);
 
 // Assumes neither side has any pawns.
 static int endGameEval(const Board &board, int turn)
@@ -106,30 +114,56 @@ static int endGameEval(const Board &board, int turn)
 //
 // 'lowBound' and 'highBound' are the possible limits of the best 'move' found
 // so far.
-static void calcHashFullPerMille(Thinker::SharedContextT &sc)
+static void calcHashFullPerMille(Thinker *th)
 {
+    Thinker::SharedContextT &sc = th->SharedContext();
+    HashStatsT &hash = sc.stats.hash;
+    const Thinker::ContextT &context = th->Context();
+
+    sc.transTable.SampleOccupancy(context.board.Ply() - context.depth, &hash);
     sc.stats.hashFullPerMille =
-        sc.transTable.NumEntries() == 0 ? 0 :
-        (uint64) sc.stats.hashWroteNew * 1000 / sc.transTable.NumEntries();
+        hash.sampled == 0 ? 0 : hash.ages[0] * 1000 / hash.sampled;
+    sc.stats.hashPageKiB = sc.transTable.PageSize() / 1024;
+}
+
+// Returns: true iff 'hashMove' (from a transposition table hit) cannot be
+//  played on 'board', meaning the entry was for some other position.  (This
+//  is slow, so it is only checked when asked for.)
+static bool isHashCollision(const Board &board, MoveT hashMove)
+{
+    MoveList mvlist;
+
+    if (hashMove == MoveNone)
+        return false;
+    board.GenerateLegalMoves(mvlist, false);
+    return mvlist.SearchSrcDstPromote(hashMove) == nullptr;
 }
 
-static void notifyNewPv(Thinker *th, const SearchPv &goodPv, Eval eval)
+static void notifyNewPv(Thinker *th, Eval eval)
 {
     // Searching at root level, so let user know the updated line.
     DisplayPv pv;
-    pv.Set(th->Context().maxDepth, eval, goodPv);
-    calcHashFullPerMille(th->SharedContext());
+    pv.Set(th->Context().maxDepth, eval,
+           SearchPv(0, th->Context().stack.Pv().Line(0)));
+    // (Moves from the transposition table need their 'chk' filled in.)
+    pv.Sanitize(th->Context().board);
+    th->ReportNodes();
+    calcHashFullPerMille(th);
     th->RspNotifyPv(th->SharedContext().stats, pv);
 
     // Update the tracked principal variation.
     th->SharedContext().pv.Update(pv);
 }
 
-Eval tryMove(Thinker *th, MoveT move, int alpha, int beta,
-             SearchPv *newPv, int *hashHitOnly)
+Eval tryMove(Thinker *th, MoveT move, int alpha, int beta, int *hashHitOnly)
 {
     int &curDepth = th->Context().depth;
     Board &board = th->Context().board;
+    int &drawPly = th->Context().drawPly;
+    // The child tracks its own subtree's 'drawPly' (so it can tell whether it
+    //  depends on its path); afterwards, it becomes part of ours.
+    int parentDrawPly = drawPly;
+    drawPly = Thinker::NoDrawPly;
     
     LOGMOVE_DEBUG(&board, move, curDepth);
     board.MakeMove(move); // switches sides
@@ -155,9 +189,10 @@ Eval tryMove(Thinker *th, MoveT move, int alpha, int beta,
     else if (beta <= Eval::LossThreshold && beta > Eval::Loss)
         beta--;
 
-    Eval myEval = minimax(th, -beta, -alpha, newPv, hashHitOnly).Invert();
+    Eval myEval = minimax(th, -beta, -alpha, hashHitOnly).Invert();
 
     curDepth--;
+    drawPly = MIN(drawPly, parentDrawPly);
 
     // restore the current board position.
     board.UnmakeMove();
@@ -177,70 +212,87 @@ Eval tryMove(Thinker *th, MoveT move, int alpha, int beta,
     return myEval;
 }
 
-static int potentialImprovement(const Board &board)
+Eval quiesce(Thinker *th, int alpha, int beta)
 {
-    uint8 turn = board.Turn();
-    int improvement = 0;
-    int lowcoord, highcoord;
+    Thinker::ContextT &context = th->Context(); // shorthand
+
+    // Search as if we were one ply below the root, which skips the root-only
+    //  bookkeeping (PV notifications, root move results).
+    context.depth = 1;
+    context.maxDepth = 0;
+    context.drawPly = Thinker::NoDrawPly;
+    return minimax(th, alpha, beta, nullptr);
+}
+
+// Called every kPollNodes nodes.  Publishes our node count, and checks
+//  whether we should stop searching (see Thinker::NeedsToMove()).
+static void pollMoveNow(Thinker *th)
+{
+    Thinker::SharedContextT &sharedContext = th->SharedContext(); // shorthand
 
-    do
+    th->ReportNodes();
+    if (sharedContext.maxNodes &&
+        sharedContext.totalNodes.load(std::memory_order_relaxed) >=
+        uint64(sharedContext.maxNodes))
     {
-        // Traipse through the enemy piece vectors.
-        if (board.PieceExists(Piece(turn ^ 1, PieceType::Queen)))
-        {
-            improvement = Eval::Queen;
-            break;
-        }
-        if (board.PieceExists(Piece(turn ^ 1, PieceType::Rook)))
-        {
-            improvement = Eval::Rook;
-            break;
-        }
-        if (board.PieceExists(Piece(turn ^ 1, PieceType::Bishop)))
-        {
-            improvement = Eval::Bishop;
-            break;
-        }
-        if (board.PieceExists(Piece(turn ^ 1, PieceType::Knight)))
-        {
-            improvement = Eval::Knight;
-            break;
-        }
-        if (board.PieceExists(Piece(turn ^ 1, PieceType::Pawn)))
-        {
-            improvement = Eval::Pawn;
-            break;
-        }
-    } while (0);
+        // The root thinker needs to know (so it stops the other searchers),
+        //  not just us.
+        Thinker::RootThinker().SignalMoveNow();
+        th->SignalMoveNow();
+    }
+
+    // Avoid processing the cmdqueue if we are already trying to punt.
+    if (!th->NeedsToMove())
+        th->PollOneCmd();
+}
+
+// Returns: EvaluateLazy(board, material, alpha, beta, margin), preferably
+//  from the eval cache.  '*lazy' is set if the result is only a partial score.
+static int staticEval(Thinker *th, const Board &board,
+                      const MaterialInfoT &material, int alpha, int beta,
+                      int margin, bool *lazy)
+{
+    Thinker::ContextT &context = th->Context(); // shorthand
+    EvalCache &evalCache = th->SharedContext().evalCache; // shorthand
+    int result;
+
+    context.evalCacheProbes++;
+    if (evalCache.Probe(board.Zobrist(), &result))
+    {
+        context.evalCacheHits++;
+        *lazy = false;
+        return result;
+    }
+    result = EvaluateLazy(board, material, alpha, beta, margin, lazy);
+    if (*lazy)
+    {
+        // (A partial score is only good for this window, so do not cache it.)
+        context.lazyEvals++;
+        return result;
+    }
+    context.fullEvals++;
+    evalCache.Store(board.Zobrist(), result);
+    return result;
+}
+
+static int potentialImprovement(const Board &board,
+                                const MaterialInfoT &material)
+{
+    uint8 turn = board.Turn();
+    // We could capture the enemy's most valuable piece.
+    int improvement = material.maxCapture[turn ^ 1];
+    // 6th and 7th ranks, from 'turn's point of view.
+    const uint64 kPromoteSoonMask =
+        turn ? 0x0000000000ffff00ULL : 0x00ffff0000000000ULL;
 
     // If we have at least a pawn on the 6th or 7th rank, we could also improve
     // by promotion.  (We include 6th rank because this potentialImprovement()
     // routine is really lazy, and calculated before any depth-1 move, as
     // opposed to after each one).
-    const std::vector<cell_t> &pvec =
-        board.PieceCoords(Piece(turn, PieceType::Pawn));
-    int len = pvec.size();
-
-    if (len)
+    if (material.HasPawns(turn) &&
+        (PawnLookup(board).pawns[turn] & kPromoteSoonMask))
     {
-        if (turn)
-        {
-            lowcoord = 8;   // 7th rank, black
-            highcoord = 23; // 6th rank, black
-        }
-        else
-        {
-            lowcoord = 40;  // 6th rank, white
-            highcoord = 55; // 7th rank, white
-        }
-        for (auto coord : pvec)
-        {
-            if (coord >= lowcoord && coord <= highcoord)
-            {
-                improvement += Eval::Queen - Eval::Pawn;
-                break;
-            }
-        }
+        improvement += Eval::Queen - Eval::Pawn;
     }
     return improvement;
 }
@@ -251,7 +303,7 @@ static int potentialImprovement(const Board &board)
 // Returns the evaluation of the found move
 // (if no move found, 'cookie' is set to -1).
 // Side effect: removes the move from the list.
-static Eval tryNextHashMove(Thinker *th, int alpha, int beta, SearchPv *newPv,
+static Eval tryNextHashMove(Thinker *th, int alpha, int beta,
                             MoveList *mvlist, int *cookie, MoveT *hashMove)
 {
     Eval myEval(EvalLoss);
@@ -264,7 +316,7 @@ static Eval tryNextHashMove(Thinker *th, int alpha, int beta, SearchPv *newPv,
         move = mvlist->Moves(i);
 
         hashHitOnly = HASH_HIT; // assume the best case
-        myEval = tryMove(th, move, alpha, beta, newPv, &hashHitOnly);
+        myEval = tryMove(th, move, alpha, beta, &hashHitOnly);
         if (hashHitOnly == HASH_HIT)
             break;
     }
@@ -301,8 +353,8 @@ static int biasDraw(int strgh, int depth)
 }
 
 // Evaluates a given board position from {board->turn}'s point of view.
-static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
-                    int *hashHitOnly)
+// The best line found is left in the search stack's 'pv' for this ply.
+static Eval minimax(Thinker *th, int alpha, int beta, int *hashHitOnly)
 {
     // Trying to order the declared variables by their struct size, to
     // increase cache hits, does not work.  Trying instead by functionality.
@@ -317,34 +369,64 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
     MoveT move;
     int preEval, improvement, i, secondBestVal;
     int cookie;
+    bool lazyEval;
     Eval myEval;
-    Board &board = th->Context().board;
-    int &curDepth = th->Context().depth;
-    int searchDepth = th->Context().maxDepth - curDepth;
+    uint64 subtreeNodes; // (only tracked at the root)
+    Thinker::ContextT &context = th->Context(); // shorthand
+    Thinker::SharedContextT &sharedContext = th->SharedContext(); // shorthand
+    Board &board = context.board;
+    int &curDepth = context.depth;
+    int searchDepth = context.maxDepth - curDepth;
     uint16 basePly = board.Ply() - curDepth;
-    int strgh = board.RelativeMaterialStrength();
-    EngineStatsT &stats = th->SharedContext().stats; // shorthand
+    EngineStatsT &stats = sharedContext.stats; // shorthand
+    SearchStack::PlyT &ss = context.stack[curDepth]; // shorthand
+    PvTable &pvTable = context.stack.Pv(); // shorthand
+    // (Copied, since deeper searches may reuse the same table entry.)
+    const MaterialInfoT material = MaterialLookup(board.MaterialKey());
 #define QUIESCING (searchDepth < 0)
+    bool inCheck = board.IsInCheck();
+    // The (incremental, so nearly free) material + piece-square score is
+    //  enough to decide how to bias draws.  The full static eval ('strgh') is
+    //  not computed until the transposition table cannot answer for us.
+    int quickStrgh = board.RelativeMaterialStrength() + board.PositionalScore();
+    int strgh;
 
     // I'm trying to use lazy initialization for this function.
-    stats.nodes++;
+    if ((++context.nodes & (kPollNodes - 1)) == 0)
+        pollMoveNow(th);
     if (!QUIESCING)
     {
         stats.nonQNodes++;
     }
-    goodPv->Clear();
+    pvTable.Clear(curDepth);
 
-    if (board.IsDrawInsufficientMaterial() ||
+    if (material.IsDrawInsufficientMaterial() ||
         board.IsDrawFiftyMove() ||
         board.IsDrawThreefoldRepetitionFast())
     {
         // Draw detected.
+        // Unless it is by material, this depends on earlier positions, which
+        //  any ancestor that came after them must know.  (Likewise below.)
+        if (!material.IsDrawInsufficientMaterial())
+        {
+            context.drawPly = MIN(context.drawPly,
+                                  board.IsDrawFiftyMove() ?
+                                  board.Ply() - board.NcpPlies() :
+                                  board.FirstOccurrencePly(board.Ply()));
+        }
         // Skew the eval a bit: If we have equal or better material, try not to
         // draw.  Otherwise, try to draw.
-        return Eval(biasDraw(strgh, curDepth));
+        return Eval(biasDraw(quickStrgh, curDepth));
+    }
+
+    if (curDepth >= kMaxPly - 1)
+    {
+        // Searched as deep as our search stack allows (which should never
+        //  practically happen).  Just evaluate.
+        return Eval(staticEval(th, board, material, alpha, beta, 0,
+                               &lazyEval));
     }
 
-    bool inCheck = board.IsInCheck();
     uint8 turn   = board.Turn();
     
     if (board.RepeatPly() != -1)
@@ -358,37 +440,15 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
         // cuts down on the search tree, but this screws up the eval of losing
         // positions -- thanks to back-propagation, we could mistakenly
         // prefer the position over a move that won or kept material.
-        improvement = -biasDraw(strgh, curDepth);
-        strgh -= improvement;
+        improvement = -biasDraw(quickStrgh, curDepth);
+        context.drawPly = MIN(context.drawPly,
+                              board.FirstOccurrencePly(board.RepeatPly()));
     }
     else
     {
         improvement = 0;
     }
 
-    if (QUIESCING && !inCheck)
-    {
-        // Putting some endgame eval right here.  No strength change is
-        // possible if opponent only has king (unless we have pawns), so movgen
-        // is not needed.  Also, (currently) don't bother with hashing since
-        // usually ncpPlies will be too high.
-        if (board.MaterialStrength(turn ^ 1) == 0 &&
-            !board.PieceExists(Piece(turn, PieceType::Pawn)))
-        {
-            return Eval(strgh + endGameEval(board, turn)); // (oh good.)
-        }
-
-        // When quiescing (inCheck is a special case because we attempt to
-        // detect checkmate even during quiesce) we assume that we can at least
-        // preserve our current strgh, by picking some theoretical move that
-        // wasn't generated.  This actually functions as our node-level
-        // evaluation function, cleverly hidden.
-        if (strgh >= beta)
-        {
-            return Eval(strgh, Eval::Win);
-        }
-    }
-
     /* Is it possible to draw by repetition from this position.
        I use 3 instead of 4 because the first quiesce depth may be a repeated
        position.
@@ -402,16 +462,36 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
         // (7 - ncpPlies below would work, but this should be better:)
         (searchDepth >= 3 - (board.Ply() - board.RepeatPly()));
 
-    TransTable &transTable = th->SharedContext().transTable; // shorthand
-    
+    TransTable &transTable = sharedContext.transTable; // shorthand
+    bool excluding = ss.excludedMove != MoveNone;
+
+    // Entries do not know how we got to their position, so we cannot use
+    //  them if our path already has a repetition in it that the search could
+    //  draw by (see 'mightDraw'), or if the fifty-move rule might kick in
+    //  during the search.  (Quiescing only adds reversible plies by evading
+    //  checks, so allowing for one quiet check and its evasion is practically
+    //  enough.)  Entries whose results depended on how *they* got there are
+    //  never used (see IsHit()).
+    bool pathMatters =
+        (board.RepeatPly() != -1 && mightDraw) ||
+        board.NcpPlies() + MAX(searchDepth, 0) + 2 >= 100;
+
     // Is there a suitable hit in the transposition table?
-    if ((!mightDraw || board.NcpPlies() == 0) &&
+    // (When excluding a move, this is a different search, so we cannot use
+    //  (or later, update) the hash.)
+    if (!pathMatters && !excluding &&
         transTable.IsHit(&hashEval, &hashMove, board.Zobrist(), searchDepth,
-                         basePly, alpha, beta, &stats))
+                         basePly, alpha, beta, &context.hashStats))
     {
+        if (sharedContext.hashDiagnostics &&
+            isHashCollision(board, hashMove))
+        {
+            context.hashStats.collisions++;
+        }
+
         // record the move (if there is one).
-        if (goodPv->Update(hashMove))
-            notifyNewPv(th, *goodPv, hashEval);
+        if (pvTable.Update(curDepth, hashMove))
+            notifyNewPv(th, hashEval);
 
         return hashEval;
     }
@@ -422,9 +502,42 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
         return Eval(Eval::Loss, Eval::Win);
     }
 
-    MoveList mvlist;
+    // A quiescing node (not in check) mostly just compares its eval against
+    //  the window (see below), which is where a lazy eval can do the job.
+    strgh = staticEval(th, board, material, alpha, beta,
+                       QUIESCING && !inCheck ?
+                       sharedContext.lazyEvalMargin : 0, &lazyEval);
+    ss.staticEval = lazyEval ? kNoStaticEval : strgh;
+    strgh -= improvement;
+
+    if (QUIESCING && !inCheck)
+    {
+        // Putting some endgame eval right here.  No strength change is
+        // possible if opponent only has king (unless we have pawns), so movgen
+        // is not needed.
+        if (material.IsBareKing(turn ^ 1) && !material.HasPawns(turn))
+        {
+            // (Specialized endgames, like KBNK, have their own ideas about
+            //  where the king should go.)
+            return Eval(material.endgame == EndgameT::MopUp ?
+                        strgh + endGameEval(board, turn) : // (oh good.)
+                        strgh);
+        }
+
+        // When quiescing (inCheck is a special case because we attempt to
+        // detect checkmate even during quiesce) we assume that we can at least
+        // preserve our current strgh, by picking some theoretical move that
+        // wasn't generated.  This actually functions as our node-level
+        // evaluation function, cleverly hidden.
+        if (strgh >= beta)
+        {
+            return Eval(strgh, Eval::Win);
+        }
+    }
+
+    MoveList &mvlist = ss.mvlist;
 
-    if (curDepth || !th->Context().mvlist.NumMoves())
+    if (curDepth || !context.mvlist.NumMoves())
     {
         // At this point, (expensive) move generation is required.
         stats.moveGenNodes++;
@@ -432,13 +545,22 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
     }
     else
     {
-        mvlist = th->Context().mvlist;
+        mvlist = context.mvlist;
+    }
+    if (excluding)
+    {
+        for (i = 0; i < mvlist.NumMoves(); i++)
+        {
+            if (mvlist.Moves(i) == ss.excludedMove)
+            {
+                mvlist.DeleteMove(i);
+                break;
+            }
+        }
     }
     MOVELIST_LOGDEBUG(mvlist);
 
-    if (QUIESCING &&
-        !board.PieceExists(Piece(0, PieceType::Pawn)) &&
-        !board.PieceExists(Piece(1, PieceType::Pawn)))
+    if (QUIESCING && material.endgame == EndgameT::MopUp)
     {
         // Endgame.  Add some intelligence to the eval.  This allows us to
         // win scenarios like KQ vs KN.
@@ -454,13 +576,18 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
 
     if (!mvlist.NumMoves())
     {
+        if (excluding)
+            return Eval(Eval::Loss, alpha); // (no other move is any good.)
+
         retVal.Set(inCheck    ? Eval::Loss : // checkmate detected
                    !QUIESCING ? 0 :          // stalemate detected
                    strgh);
 
         // Update the transposition table entry if needed.
         transTable.ConditionalUpdate(retVal, MoveNone, board.Zobrist(),
-                                     searchDepth, basePly, &stats);
+                                     searchDepth, basePly,
+                                     context.drawPly < board.Ply(),
+                                     &context.hashStats);
         return retVal;
     }
 
@@ -472,7 +599,9 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
             retVal.Set(strgh, Eval::Win);
             // Update the transposition table entry if needed.
             transTable.ConditionalUpdate(retVal, MoveNone, board.Zobrist(),
-                                         searchDepth, basePly, &stats);
+                                         searchDepth, basePly,
+                                         context.drawPly < board.Ply(),
+                                         &context.hashStats);
             return retVal;
         }
 
@@ -491,8 +620,16 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
         // This doesn't work well, perhaps poor interaction w/history table:
         // mvlist->SortByCapWorth(board);
         
+        // Try killer moves right after the other preferred moves.  (The
+        //  root's moves are ordered by computermove() instead.)
+        if (curDepth)
+        {
+            for (MoveT killer : ss.killers)
+                mvlist.PreferMove(killer);
+        }
+
         // Try the principal variation move (if applicable) first.
-        mvlist.UseAsFirstMove(th->SharedContext().pv.Hint(curDepth));
+        mvlist.UseAsFirstMove(sharedContext.pv.Hint(curDepth));
 
         // If we find no better moves ...
         retVal.Set(Eval::Loss, alpha);
@@ -509,7 +646,7 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
 
     if (searchDepth == 1)
     {
-        improvement += potentialImprovement(board);
+        improvement += potentialImprovement(board, material);
     }
 
 #if 1
@@ -523,7 +660,6 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
     cookie = -1;
 #endif
 
-    SearchPv childPv(curDepth + 1);
     MoveT bestMove = MoveNone;
     
     for (i = 0, secondBestVal = alpha;
@@ -536,7 +672,7 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
         {
             i--; // this counters i++
 
-            myEval = tryNextHashMove(th, alpha, beta, &childPv,
+            myEval = tryNextHashMove(th, alpha, beta,
                                      &mvlist, &cookie, &hashMove);
             if (cookie == -1) /* no move found? */
                 continue;
@@ -554,14 +690,16 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
                 // First move is special (for PV).  We process it (almost)
                 // normally.
                 move = mvlist.Moves(i);
+                subtreeNodes = context.nodes;
                 SearchersMakeMove(move);
-                myEval = tryMove(th, move, alpha, beta, &childPv, nullptr);
+                myEval = tryMove(th, move, alpha, beta, nullptr);
                 SearchersUnmakeMove();
+                subtreeNodes = context.nodes - subtreeNodes;
             }
             else if (i < mvlist.NumMoves() &&  // have a move to search?
                      // have someone to delegate it to?
                      SearchersDelegateSearch(alpha, beta, mvlist.Moves(i),
-                                             curDepth, th->Context().maxDepth))
+                                             curDepth, context.maxDepth))
             {
                 // We delegated it successfully.
                 continue;
@@ -571,7 +709,10 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
                 // Either do not have a move to search, or nobody to search on
                 //  it.  Wait for an eval to become available.  May be
                 //  interrupted if we need to move.
-                if (SearchersWaitOne(*th, myEval, move, childPv))
+                PvRefT searcherPv;
+                int searcherDrawPly;
+                if (SearchersWaitOne(*th, myEval, move, subtreeNodes,
+                                     searcherDrawPly, searcherPv))
                 {
                     if (th->NeedsToMove())
                     {
@@ -586,6 +727,9 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
                     i--;
                     continue;
                 }
+                // (This must be copied before the searcher searches again.)
+                pvTable.Set(curDepth + 1, searcherPv);
+                context.drawPly = MIN(context.drawPly, searcherDrawPly);
                 i--; // this counters i++
             }
         }
@@ -626,24 +770,27 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
                 continue;
             }
 
-            myEval = tryMove(th, move, alpha, beta, &childPv, nullptr);
+            subtreeNodes = context.nodes;
+            myEval = tryMove(th, move, alpha, beta, nullptr);
+            subtreeNodes = context.nodes - subtreeNodes;
         }
 
-        // Avoid processing the cmdqueue if we are already trying to punt.
-        if (!th->NeedsToMove())
-            th->PollOneCmd();
-        
         // If we need to move, we cannot trust (and should not hash) 'myEval'.
         // We must go with the best value/move we already had ... if any.
-        if (th->NeedsToMove() ||
-            (th->SharedContext().maxNodes &&
-             stats.nodes >= th->SharedContext().maxNodes))
+        // (NeedsToMove() is just a flag check; the cmdqueue and node limit are
+        //  only polled every kPollNodes nodes.)
+        if (th->NeedsToMove())
         {
             if (masterNode)
                 SearchersBail(); // Wait for any searchers to terminate.
             return retVal.BumpHighBoundToWin();
         }
 
+        // Remember how much effort this root move took, so the next iteration
+        //  can search the (likely) best moves first.
+        if (curDepth == 0)
+            context.mvlist.SetResult(move, subtreeNodes, myEval);
+
         // In case of a <= alpha exact eval, this can at least tighten
         //  the evaluation of this position.  Even though we don't record the
         //  move, I think that's good enough to avoid 'bestVal'.
@@ -663,12 +810,22 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
             bestMove = move;
             alpha = newLowBound;
 
-            if (goodPv->UpdateFromChildPv(bestMove, childPv))
-                notifyNewPv(th, *goodPv, myEval);
+            if (pvTable.UpdateFromChild(curDepth, bestMove))
+                notifyNewPv(th, myEval);
             
             if (newLowBound >= beta) // ie, will leave other side just as bad
                                      // off (if not worse)
             {
+                // Quiet moves that cause a cutoff are likely to do so in
+                //  sibling positions as well.
+                if (!QUIESCING &&
+                    bestMove.promote == PieceType::Empty &&
+                    (bestMove.IsCastle() ||
+                     board.PieceAt(bestMove.dst).IsEmpty()))
+                {
+                    context.stack.StoreKiller(curDepth, bestMove);
+                }
+
                 if (masterNode && SearchersAreSearching())
                 {
                     SearchersBail();
@@ -716,8 +873,13 @@ static Eval minimax(Thinker *th, int alpha, int beta, SearchPv *goodPv,
     }
 
     // Update the transposition table entry if needed.
-    transTable.ConditionalUpdate(retVal, bestMove, board.Zobrist(),
-                                 searchDepth, basePly, &stats);
+    if (!excluding)
+    {
+        transTable.ConditionalUpdate(retVal, bestMove, board.Zobrist(),
+                                     searchDepth, basePly,
+                                     context.drawPly < board.Ply(),
+                                     &context.hashStats);
+    }
 
     return retVal;
 }
@@ -760,12 +922,12 @@ static bool shouldResign(const Board &board, Eval myEval, bool bPonder)
 void computermove(Thinker *th, bool bPonder)
 {
     Eval myEval;
-    SearchPv pv(0);
     Thinker::ContextT &context = th->Context();
+    const PvTable &pvTable = context.stack.Pv();
     Thinker::SharedContextT &sharedContext = th->SharedContext();
     Board &board = context.board;
     bool resigned = false;
-    MoveList mvlist;
+    RootMoveList &mvlist = context.mvlist;
     MoveT move = MoveNone;
 
     // Do impose some kind of max search depth to prevent a tight loop (and a
@@ -779,6 +941,9 @@ void computermove(Thinker *th, bool bPonder)
     context.depth = 0; // start search from root depth.
 
     sharedContext.stats.Clear();
+    sharedContext.totalNodes = 0;
+    // (The table may still be getting cleared in the background.)
+    sharedContext.transTable.WaitUntilReady();
 
     // If we can claim a draw without moving, do so w/out thinking.
     if (canClaimDraw(board))
@@ -790,7 +955,10 @@ void computermove(Thinker *th, bool bPonder)
     if (sharedContext.randomMoves)
         board.Randomize();
 
-    board.GenerateLegalMoves(mvlist, false);
+    // Unless we were told to only consider certain moves, consider them all.
+    if (!mvlist.NumMoves())
+        board.GenerateLegalMoves(mvlist, false);
+    mvlist.ClearResults();
 
     // Use the principal variation move (if it exists) if we run out of
     // time before we figure out a move to recommend.
@@ -810,6 +978,7 @@ void computermove(Thinker *th, bool bPonder)
     {
         // setup known search parameters across the slaves.
         SearchersSetBoard(board);
+        context.stack.ClearKillers();
 
         int &maxDepth = context.maxDepth;
         
@@ -818,6 +987,8 @@ void computermove(Thinker *th, bool bPonder)
              maxDepth++)
         {
             LOG_DEBUG("ply %d searching level %d\n", board.Ply(), maxDepth);
+            mvlist.ClearResults();
+            context.drawPly = Thinker::NoDrawPly;
             myEval = minimax(th,
                              // Could use Eval::LossThreshold here w/a
                              // different resign strategy, but right now we
@@ -825,12 +996,15 @@ void computermove(Thinker *th, bool bPonder)
                              Eval::Loss + maxDepth,
                              // Try to find the shortest mates possible.
                              Eval::Win - (maxDepth + 1),
-                             &pv, nullptr);
+                             nullptr);
 
             // minimax() might find MoveNone if it has to bail before it can fully
-            //  think about the first move.
-            if (pv.Moves(0) != MoveNone)
-                move = pv.Moves(0);
+            //  think about the first move.  (We look the move up since it
+            //  might have come from the transposition table, which does not
+            //  record 'chk'.)
+            MoveT *pvMove = mvlist.SearchSrcDstPromote(pvTable.Moves(0, 0));
+            if (pvMove != nullptr)
+                move = *pvMove;
 
             if (th->NeedsToMove())
                 break;
@@ -847,6 +1021,12 @@ void computermove(Thinker *th, bool bPonder)
             
             sharedContext.pv.CompletedSearch();
 
+            // Moves that needed the largest subtrees to refute are the most
+            //  likely to become the new best move, so search them first (after
+            //  the current best move) in the next iteration.  This also
+            //  controls the order in which root moves are delegated.
+            mvlist.SortBySubtreeSize(move);
+
             if (sharedContext.canResign && shouldResign(board, myEval, bPonder))
             {
                 // we're in a really bad situation
@@ -871,7 +1051,8 @@ void computermove(Thinker *th, bool bPonder)
         context.maxDepth = 0; // reset this
     }
 
-    calcHashFullPerMille(th->SharedContext());
+    th->ReportNodes();
+    calcHashFullPerMille(th);
     th->RspNotifyStats(sharedContext.stats);
 
     if (resigned)
@@ -21,7 +21,12 @@
 // Think on 'th's position, and recommend either: a move, draw, or resign.
 void computermove(Thinker *th, bool bPonder);
 
-Eval tryMove(Thinker *th, MoveT move, int alpha, int beta,
-             SearchPv *newPv, int *hashHitOnly);
+// Leaves the resulting line in row (depth + 1) of th->Context().stack.Pv().
+Eval tryMove(Thinker *th, MoveT move, int alpha, int beta, int *hashHitOnly);
+
+// Quiesces (ie searches with maxDepth < 0) the position on 'th's board, and
+//  returns its eval from the side to move's point of view.  Used by the
+//  evaluation tuner, which runs this via Thinker::PostCmd().
+Eval quiesce(Thinker *th, int alpha, int beta);
 
 #endif // COMP_H
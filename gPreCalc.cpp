@@ -17,6 +17,7 @@
 #include "aSystem.h"
 #include "Eval.h"
 #include "gPreCalc.h"
+#include "Material.h"
 #include "Variant.h"
 
 using arctic::File;
@@ -380,6 +381,15 @@ uint64 random64(void)
         (((uint64) random()) << 32) ^ ((uint64) random());
 }
 
+// A (reproducible) splitmix64 generator, for the zobrist keys.
+static uint64 zobristRandom(uint64 *state)
+{
+    uint64 z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
 
 // initialize gPreCalc.
 void gPreCalcInit(int64 userSpecifiedHashSize, int userSpecifiedNumThreads)
@@ -451,6 +461,7 @@ void gPreCalcInit(int64 userSpecifiedHashSize, int userSpecifiedNumThreads)
     Piece::SetWorth(PieceType::Queen,  Eval::Queen);
 
     // initialize zobrist hashing.
+    uint64 zobristState = kZobristSeed;
     for (i = 0; i < NUM_SQUARES; i++)
     {
         for (j = 0; j < kMaxPieces; j++)
@@ -459,18 +470,30 @@ void gPreCalcInit(int64 userSpecifiedHashSize, int userSpecifiedNumThreads)
                 // Using 0 for empty squares simplifies zobrist calculation
                 // when making moves later (do not have to XOR in empty squares,
                 // but it is not an error to do so).
-                (j >> NUM_PLAYERS_BITS) ? random64() : 0;
+                (j >> NUM_PLAYERS_BITS) ? zobristRandom(&zobristState) : 0;
         }
 
-        gPreCalc.zobrist.ebyte[i] = random64();
+        gPreCalc.zobrist.ebyte[i] = zobristRandom(&zobristState);
         
         if (i < 16)
         {
             // We also use 0 for the cbyte where no one can castle.
-            gPreCalc.zobrist.cbyte[i] = (i > 0) ? random64() : 0;
+            gPreCalc.zobrist.cbyte[i] =
+                (i > 0) ? zobristRandom(&zobristState) : 0;
+        }
+    }
+    gPreCalc.zobrist.turn = zobristRandom(&zobristState);
+
+    // initialize material keys.
+    for (i = 0; i < NUM_SQUARES; i++)
+    {
+        for (j = 0; j < kMaxPieces; j++)
+        {
+            Piece piece(j & NUM_PLAYERS_MASK, PieceType(j >> NUM_PLAYERS_BITS));
+            gPreCalc.materialKey[j] [i] = MaterialKeyInc(piece, i);
         }
     }
-    gPreCalc.zobrist.turn = random64();
+    PstRefresh();
 
     // We could clamp these to the limits of the local engine; but eventually
     //  we might support interfacing to remote engines, and then that would be
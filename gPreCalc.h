@@ -16,6 +16,7 @@
 
 #include "aTypes.h"
 #include "Piece.h"
+#include "Pst.h"
 #include "ref.h"
 
 #ifdef __cplusplus
@@ -63,6 +64,12 @@ typedef struct {
         uint64 ebyte[NUM_SQUARES];
     } zobrist;
 
+    // (pre-calculated) material key support.  See Material.h.
+    uint64 materialKey[kMaxPieces] [NUM_SQUARES];
+
+    // (pre-calculated) piece-square tables.  See Pst.h.
+    PhasedScoreT pst[kMaxPieces] [NUM_SQUARES];
+
     uint8 castleMask[NUM_SQUARES];
 
     int userSpecifiedNumThreads;
@@ -76,6 +83,11 @@ extern GPreCalcT gPreCalc;
 void gPreCalcInit(int64 userSpecifiedHashSize, int userSpecifiedNumThreads);
 uint64 random64(void); // generate a 64-bit random number.
 
+// The zobrist keys are generated from this seed (by our own generator, not
+//  random()), so they are the same from run to run.  Anything saved that
+//  depends on them (like a transposition table) should record it.
+const uint64 kZobristSeed = 0x2545f4914f6cdd1dULL;
+
 #ifdef __cplusplus
 }
 #endif
@@ -173,8 +173,8 @@ int main(int argc, char *argv[])
         }
     }
 
-    // Must be done before seeding, if we want reproducable results.  Also must
-    //  be done before any Boards (or anything that depends on it) are declared.
+    // Must be done before any Boards (or anything that depends on it) are
+    //  declared.  (The zobrist keys do not depend on the seed.)
     gPreCalcInit(hashTableSize, numCpuThreads);
     srandom(CurrentTime() / 1000000);
 
@@ -0,0 +1,525 @@
+//--------------------------------------------------------------------------
+//    selfplay.cpp - headless self-play, for generating training data.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+// Usage: arctic-selfplay [options] -o=<outfile>
+//
+// Plays engine-vs-engine games at a fixed node budget, starting each from a
+//  few random plies, and appends every (non-check, non-mate-score) position
+//  to <outfile> as it goes.  Games are played by one worker process per core
+//  (the engine supports only one root Engine per process), each with its own
+//  single-threaded Engine.  A worker that crashes is restarted, but one that
+//  cannot write its records stops the run.  SIGINT or SIGTERM finish the
+//  current move, save every completed game, and exit.
+//
+// <outfile> is a plain array of kRecordSize-byte records, all fields little-
+//  endian:
+//  bytes 0-31:  the pieces, two squares per byte (a1 in the low nibble of
+//               byte 0, b1 in its high nibble, ..., h8 in the high nibble of
+//               byte 31).  Each nibble is a Piece::ToIndex() (0 == empty).
+//  bytes 32-33: (int16) search score, in centipawns, from White's point of
+//               view.
+//  byte 34:     game result, from White's point of view (0 == loss,
+//               1 == draw, 2 == win).
+//  byte 35:     bit 0: side to move (0 == White); bits 1-4: castling rights
+//               (White O-O, White O-O-O, Black O-O, Black O-O-O).
+//  byte 36:     en passant coord (a1 == 0), or 0xff if none.
+//  byte 37:     plies since the last capture or pawn move (clamped to 255).
+//  bytes 38-39: (uint16) ply (0 == White's first move).
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "aSystem.h"
+#include "clockUtil.h"
+#include "Engine.h"
+#include "gPreCalc.h"
+#include "log.h"
+#include "MoveList.h"
+#include "Timer.h"
+#include "Variant.h"
+
+static const int kRecordSize = 40;
+// Completed games are written out as soon as they finish, and synced to disk
+//  at least this often (in seconds).
+static const int kSyncInterval = 30;
+// Games still going after this many plies are adjudicated as draws.
+static const int kMaxGamePlies = 400;
+// Exit status of a worker that could not write its records.  Unlike a crash,
+//  this is not worth restarting the worker for.
+static const int kWriteFailedStatus = 2;
+
+struct SelfPlayOptionsT
+{
+    int numWorkers;
+    int maxNodes;     // search budget, per move
+    int numGames;     // total, for all workers.  0 == no limit
+    int randomPlies;  // random moves played before the engines take over
+    int hashMiB;      // transposition table size, per worker
+    std::string outFile;
+};
+
+// Set by SIGINT/SIGTERM.
+static volatile sig_atomic_t gStopRequested;
+
+static void usage(const char *programName)
+{
+    printf("usage: %s [-p=<numworkers>] [-n=<nodes>] [-g=<games>] "
+           "[-r=<randomplies>]\n"
+           "\t[-h=<hashMiB>] -o=<outfile>\n"
+           "\t'numworkers' default == number of online processors\n"
+           "\t'nodes' (per move) default == 5000\n"
+           "\t'games' default == 0 (play until interrupted)\n"
+           "\t'randomplies' default == 8\n"
+           "\t'hashMiB' (per worker) default == 16\n",
+           programName);
+    exit(0);
+}
+
+static void onStopSignal(int signum)
+{
+    gStopRequested = 1;
+}
+
+// Streams records to a file that other workers may be appending to at the same
+//  time.  Since the file is opened with O_APPEND and we only ever write()
+//  whole records, records from different workers do not interleave.  A write
+//  that fails (or is short, which would leave a partial record) ends the
+//  process with kWriteFailedStatus.
+class RecordWriter
+{
+public:
+    explicit RecordWriter(int fd); // 'fd' must be opened with O_APPEND.
+    ~RecordWriter();
+    void Append(const uint8 *record);
+    void Flush();
+    void Sync(); // Flush(), then fsync().
+private:
+    int fd;
+    std::vector<uint8> buffer;
+    bigtime_t lastSyncTime;
+};
+
+RecordWriter::RecordWriter(int fd) : fd(fd), lastSyncTime(CurrentTime()) {}
+
+RecordWriter::~RecordWriter()
+{
+    Sync();
+    close(fd);
+}
+
+void RecordWriter::Append(const uint8 *record)
+{
+    buffer.insert(buffer.end(), record, record + kRecordSize);
+}
+
+void RecordWriter::Flush()
+{
+    while (!buffer.empty())
+    {
+        ssize_t rv = write(fd, buffer.data(), buffer.size());
+        if (rv < 0 && errno == EINTR)
+            continue;
+        // (Finishing a short write with another write() could let another
+        //  worker's records in between, so it is as bad as a failed one.)
+        if (rv != ssize_t(buffer.size()))
+        {
+            const char *problem = rv < 0 ? strerror(errno) : "short write";
+            LOG_EMERG("%s: write failed (%s)\n", __func__, problem);
+            fprintf(stderr, "worker %d: write failed (%s)\n", getpid(),
+                    problem);
+            // (Engines do not support destruction, so skip the normal exit
+            //  path.)
+            _exit(kWriteFailedStatus);
+        }
+        break;
+    }
+    buffer.clear();
+
+    if (CurrentTime() - lastSyncTime >= kSyncInterval * 1000000LL)
+    {
+        fsync(fd);
+        lastSyncTime = CurrentTime();
+    }
+}
+
+void RecordWriter::Sync()
+{
+    Flush();
+    fsync(fd);
+    lastSyncTime = CurrentTime();
+}
+
+// Packs 'board' and 'score' into 'record' (see the top of this file).  The
+//  result is filled in later, once the game is over.
+static void packRecord(uint8 *record, const Board &board, int score)
+{
+    const Position &position = board.Position();
+    cell_t epCoord = position.EnPassantCoord();
+
+    memset(record, 0, kRecordSize);
+    for (cell_t coord = 0; coord < NUM_SQUARES; coord++)
+    {
+        record[coord / 2] |=
+            position.PieceAt(coord).ToIndex() << (coord & 1 ? 4 : 0);
+    }
+    record[32] = uint16(score) & 0xff;
+    record[33] = uint16(score) >> 8;
+    record[35] = position.Turn() |
+        (position.CanCastleOO(0) << 1) | (position.CanCastleOOO(0) << 2) |
+        (position.CanCastleOO(1) << 3) | (position.CanCastleOOO(1) << 4);
+    record[36] = epCoord == FLAG ? 0xff : epCoord;
+    record[37] = MIN(position.NcpPlies(), 255);
+    record[38] = position.Ply() & 0xff;
+    record[39] = position.Ply() >> 8;
+}
+
+// Plays 'numPlies' random moves on 'board'.
+// Returns: false iff the game ended before we were done.
+static bool playRandomPlies(Board &board, int numPlies)
+{
+    MoveList mvlist;
+
+    for (int i = 0; i < numPlies; i++)
+    {
+        // (Shuffles the order moves are generated in.)
+        board.Randomize();
+        board.GenerateLegalMoves(mvlist, false);
+        if (mvlist.NumMoves() == 0)
+            return false;
+        board.MakeMove(mvlist.Moves(random() % mvlist.NumMoves()));
+    }
+    return true;
+}
+
+// Plays one game to completion (unless interrupted), and appends its positions
+//  to 'writer'.
+static void playGame(Engine &eng, RecordWriter &writer,
+                     const SelfPlayOptionsT &options)
+{
+    Board board;
+    MoveList mvlist;
+    std::vector<uint8> records; // (this game's, so far)
+    int result = -1; // (see the top of this file.)
+    MoveT move;
+    bool moved, resigned, claimedDraw;
+    Eval pvEval;
+    bool havePv;
+
+    do
+    {
+        board.SetPosition(Variant::Current()->StartingPosition());
+    } while (!playRandomPlies(board, options.randomPlies));
+
+    Engine::RspHandlerT handler;
+    handler.Move = [&](Engine &, MoveT myMove)
+    {
+        move = myMove;
+        moved = true;
+    };
+    handler.Draw = [&](Engine &, MoveT)
+    {
+        claimedDraw = true;
+    };
+    handler.Resign = [&](Engine &)
+    {
+        resigned = true;
+    };
+    handler.NotifyStats = [](Engine &, const EngineStatsT &) {};
+    handler.NotifyPv = [&](Engine &, const EnginePvArgsT &pvArgs)
+    {
+        pvEval = pvArgs.pv.Eval();
+        havePv = true;
+    };
+    handler.SearchDone = [](Engine &, const EngineSearchDoneArgsT &) {};
+    eng.SetRspHandler(handler);
+
+    eng.CmdNewGame();
+    eng.CmdSetBoard(board);
+
+    while (result == -1)
+    {
+        uint8 turn = board.Turn();
+
+        board.GenerateLegalMoves(mvlist, false);
+        if (mvlist.NumMoves() == 0)
+        {
+            result = !board.IsInCheck() ? 1 : turn == 0 ? 0 : 2;
+            break;
+        }
+        if (board.IsDrawInsufficientMaterial() || board.IsDrawFiftyMove() ||
+            board.IsDrawThreefoldRepetition() ||
+            board.Ply() >= kMaxGamePlies)
+        {
+            result = 1;
+            break;
+        }
+        if (gStopRequested)
+            return; // (abandon this game)
+
+        moved = resigned = claimedDraw = havePv = false;
+        eng.CmdThink(Clock());
+        while (!moved && !resigned && !claimedDraw)
+            eng.ProcessOneRsp();
+
+        if (resigned)
+            result = turn == 0 ? 0 : 2;
+        else if (claimedDraw)
+            result = 1;
+        else
+        {
+            // Quiet(er) positions with a real score make better training
+            //  data.
+            if (havePv && !board.IsInCheck() && !pvEval.DetectedWinOrLoss())
+            {
+                int score = pvEval.LowBound();
+                score = MAX(MIN(score, 32000), -32000);
+                records.resize(records.size() + kRecordSize);
+                packRecord(&records[records.size() - kRecordSize], board,
+                           turn == 0 ? score : -score);
+            }
+            board.MakeMove(move);
+            eng.CmdMakeMove(move);
+        }
+    }
+
+    for (size_t i = 0; i < records.size(); i += kRecordSize)
+    {
+        records[i + 34] = result;
+        writer.Append(&records[i]);
+    }
+}
+
+// Runs in its own process.  Plays games until 'gamesDone' (which is shared
+//  with the parent, and counts games written out by this worker and any it
+//  replaced) reaches 'numGames' (0 == no limit), writing them to 'fd'.
+static void runWorker(const SelfPlayOptionsT &options, int fd, int numGames,
+                      std::atomic<int> &gamesDone)
+{
+    RecordWriter writer(fd);
+
+    srandom(CurrentTime() ^ (bigtime_t(getpid()) << 16));
+    arctic::Timer::InitSubsystem(); // (threads do not survive fork())
+
+    Engine eng; // This is the root engine (for this process).
+    eng.Config().SetSpin(Config::MaxThreadsSpin, 1);
+    eng.Config().SetSpin(Config::MaxMemorySpin, options.hashMiB);
+    eng.Config().SetSpin(Config::MaxNodesSpin, options.maxNodes);
+    // (Varies the engine's choice between equal moves.)
+    eng.Config().SetCheckbox(Config::RandomMovesCheckbox, true);
+
+    while ((numGames == 0 || gamesDone < numGames) && !gStopRequested)
+    {
+        playGame(eng, writer, options);
+        writer.Flush();
+        gamesDone++;
+    }
+    writer.Sync();
+    // (Engines do not support destruction, so skip the normal exit path.)
+    _exit(0);
+}
+
+static pid_t startWorker(const SelfPlayOptionsT &options, int fd, int numGames,
+                         std::atomic<int> &gamesDone)
+{
+    pid_t pid = fork();
+
+    if (pid == 0)
+        runWorker(options, fd, numGames, gamesDone);
+    else if (pid < 0)
+        fprintf(stderr, "fork() failed: %s\n", strerror(errno));
+    return pid;
+}
+
+int main(int argc, char *argv[])
+{
+    SelfPlayOptionsT options = {SystemTotalProcessors(), 5000, 0, 8, 16, ""};
+    char buf[256];
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (sscanf(argv[i], "-p=%d", &options.numWorkers) == 1)
+        {
+            if (options.numWorkers < 1)
+                usage(argv[0]);
+        }
+        else if (sscanf(argv[i], "-n=%d", &options.maxNodes) == 1)
+        {
+            if (options.maxNodes < 1)
+                usage(argv[0]);
+        }
+        else if (sscanf(argv[i], "-g=%d", &options.numGames) == 1)
+        {
+            if (options.numGames < 0)
+                usage(argv[0]);
+        }
+        else if (sscanf(argv[i], "-r=%d", &options.randomPlies) == 1)
+        {
+            if (options.randomPlies < 0)
+                usage(argv[0]);
+        }
+        else if (sscanf(argv[i], "-h=%d", &options.hashMiB) == 1)
+        {
+            if (options.hashMiB < 0)
+                usage(argv[0]);
+        }
+        else if (sscanf(argv[i], "-o=%255s", buf) == 1)
+            options.outFile = buf;
+        else
+            usage(argv[0]);
+    }
+    if (options.outFile.empty())
+        usage(argv[0]);
+
+    LogInit();
+    // Must be done before any Boards are declared (and before we fork, so
+    //  every worker shares the same zobrist keys).
+    gPreCalcInit(-1, 1);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onStopSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    // (Opened once, here, so a bad path is reported just once; the workers
+    //  share it.)
+    int fd = open(options.outFile.c_str(), O_WRONLY | O_CREAT | O_APPEND,
+                  0644);
+    if (fd < 0)
+    {
+        fprintf(stderr, "could not open '%s': %s\n", options.outFile.c_str(),
+                strerror(errno));
+        return 1;
+    }
+
+    // How many games each worker has finished.  This is shared with the
+    //  workers, so a restarted one can pick up where its predecessor left off.
+    void *shared = mmap(nullptr, options.numWorkers * sizeof(std::atomic<int>),
+                        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                        -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        fprintf(stderr, "mmap() failed: %s\n", strerror(errno));
+        return 1;
+    }
+    std::atomic<int> *gamesDone = static_cast<std::atomic<int> *>(shared);
+    for (int i = 0; i < options.numWorkers; i++)
+        new (&gamesDone[i]) std::atomic<int>(0);
+
+    // Split the games evenly between the workers.
+    std::vector<pid_t> workers(options.numWorkers);
+    std::vector<int> workerGames(options.numWorkers);
+    for (int i = 0; i < options.numWorkers; i++)
+    {
+        workerGames[i] = options.numGames / options.numWorkers +
+            (i < options.numGames % options.numWorkers ? 1 : 0);
+        if (options.numGames != 0 && workerGames[i] == 0)
+            workers[i] = -1; // (more workers than games)
+        else
+            workers[i] = startWorker(options, fd, workerGames[i],
+                                     gamesDone[i]);
+    }
+
+    bool failed = false;
+    int numRunning = 0;
+    for (pid_t pid : workers)
+        numRunning += pid > 0;
+    while (numRunning > 0)
+    {
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            if (errno == EINTR)
+            {
+                // Make sure the workers heard about it too (they will not
+                //  have, if the signal was aimed at just us).
+                for (pid_t worker : workers)
+                {
+                    if (worker > 0)
+                        kill(worker, SIGTERM);
+                }
+                continue;
+            }
+            break;
+        }
+        for (int i = 0; i < options.numWorkers; i++)
+        {
+            if (workers[i] != pid)
+                continue;
+            workers[i] = -1;
+            numRunning--;
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+                continue;
+            if (!WIFSIGNALED(status))
+            {
+                // It gave up (most likely, it could not write its records),
+                //  and so would any replacement.  Stop everything.
+                fprintf(stderr, "worker %d failed (exit status %d), "
+                        "stopping\n", pid, WEXITSTATUS(status));
+                if (!failed)
+                {
+                    failed = true;
+                    gStopRequested = 1;
+                    for (pid_t worker : workers)
+                    {
+                        if (worker > 0)
+                            kill(worker, SIGTERM);
+                    }
+                }
+            }
+            // A crashed worker only loses its current game, so start over
+            //  with whatever games it had left.  (If it crashed between
+            //  writing a game and counting it, that game is played again.)
+            else if (!gStopRequested &&
+                     (workerGames[i] == 0 || gamesDone[i] < workerGames[i]))
+            {
+                fprintf(stderr, "worker %d died (status %d), restarting\n",
+                        pid, status);
+                if ((workers[i] = startWorker(options, fd, workerGames[i],
+                                              gamesDone[i])) > 0)
+                {
+                    numRunning++;
+                }
+            }
+        }
+    }
+
+    close(fd);
+
+    struct stat st;
+    if (stat(options.outFile.c_str(), &st) == 0)
+    {
+        printf("%s: %lld positions\n", options.outFile.c_str(),
+               (long long) st.st_size / kRecordSize);
+        if (st.st_size % kRecordSize)
+        {
+            fprintf(stderr, "%s: has a partial record; records after it are "
+                    "misaligned\n", options.outFile.c_str());
+        }
+    }
+    return failed ? 1 : 0;
+}
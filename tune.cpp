@@ -0,0 +1,467 @@
+//--------------------------------------------------------------------------
+//       tune.cpp - Texel-style tuner for the evaluation weights.
+//                           -------------------
+//  copyright            : (C) 2007 by Lucian Landry
+//  email                : lucian_b_landry@yahoo.com
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at https://mozilla.org/MPL/2.0/.
+//--------------------------------------------------------------------------
+
+// Usage: arctic-tune [options] <file> [<file> ...]
+//
+// Each line of each <file> is a FEN (or EPD, which lacks the move counters)
+//  followed by the game's result, in any of the usual notations ("1-0", "0-1",
+//  "1/2-1/2", or "[1.0]", "[0.5]", "[0.0]").  The tuner quiesces every
+//  position, maps the score to an expected result with a logistic curve, and
+//  then adjusts the weights in gEvalParams (one at a time, by coordinate
+//  descent) to minimize the mean squared difference between the expected and
+//  actual results.  Quiescing is done in parallel by one Thinker per thread.
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "aSemaphore.h"
+#include "aSystem.h"
+#include "clockUtil.h"
+#include "comp.h"
+#include "EvalParams.h"
+#include "gPreCalc.h"
+#include "log.h"
+#include "Pawns.h"
+#include "Thinker.h"
+#include "Timer.h"
+#include "ui.h"
+#include "uiUtil.h"
+
+using arctic::Semaphore;
+
+// Positions are handed out to the searching threads this many at a time.
+static const int kBlockSize = 256;
+
+struct TuneDataT
+{
+    std::vector<Position> positions;
+    std::vector<float> results; // 1 == White won, 0.5 == draw, 0 == Black won
+    std::vector<int> scores;    // quiesced scores, from White's point of view
+};
+
+struct TuneOptionsT
+{
+    int numThreads;
+    int maxIterations;
+    int step;
+    double k; // < 0 implies "fit it to the data"
+    std::string only; // only tune params whose names start with this
+    std::string paramsFile; // initial weights, if non-empty
+    std::string outFile;
+};
+
+static void usage(const char *programName)
+{
+    printf("usage: %s [-p=<numthreads>] [-i=<maxiterations>] [-s=<step>] "
+           "[-k=<K>]\n"
+           "\t[--only=<prefix>] [--params=<file>] [-o=<outfile>] "
+           "<file> [<file> ...]\n"
+           "\t'numthreads' default == number of online processors\n"
+           "\t'maxiterations' default == 100\n"
+           "\t'step' (how much each weight is nudged) default == 1\n"
+           "\t'K' (logistic scaling) default == fitted to the data\n"
+           "\t'prefix' restricts tuning to weights named like it "
+           "(e.g. 'pst.knight')\n"
+           "\t'outfile' default == arctic-tune.params\n",
+           programName);
+    exit(0);
+}
+
+// Nothing should need the UI except fenToBoard() (for error reporting).
+static void tuneNotifyError(char *reason)
+{
+    fprintf(stderr, "%s\n", reason);
+}
+
+// Returns: true iff 'str' is an (optionally negative) integer.
+static bool isInteger(const std::string &str)
+{
+    size_t i = str[0] == '-' ? 1 : 0;
+    return i < str.size() &&
+        str.find_first_not_of("0123456789", i) == std::string::npos;
+}
+
+// Extracts the game result from 'str' (see the top of this file).
+// Returns: true iff one was found.
+static bool parseResult(const std::string &str, float *result)
+{
+    size_t bracket = str.find('[');
+
+    if (str.find("1/2-1/2") != std::string::npos)
+        *result = 0.5;
+    else if (str.find("1-0") != std::string::npos)
+        *result = 1.0;
+    else if (str.find("0-1") != std::string::npos)
+        *result = 0.0;
+    else if (bracket != std::string::npos)
+    {
+        *result = atof(str.c_str() + bracket + 1);
+        return *result >= 0.0 && *result <= 1.0;
+    }
+    else
+        return false;
+    return true;
+}
+
+// Returns: number of positions loaded from 'fileName', or -1 if it could not
+//  be read.
+static int loadFile(const std::string &fileName, TuneDataT &data)
+{
+    std::ifstream file(fileName);
+    std::string line;
+    Board board;
+    int numLoaded = 0, lineNum = 0;
+
+    if (!file)
+        return -1;
+
+    while (std::getline(file, line))
+    {
+        std::istringstream tokens(line);
+        std::string fields[6], fen, rest;
+        float result;
+
+        lineNum++;
+        for (int i = 0; i < 4; i++)
+            tokens >> fields[i];
+        // EPD lacks the halfmove clock and fullmove number; fenToBoard() does
+        //  not.
+        std::streampos countersPos = tokens.tellg();
+        tokens >> fields[4] >> fields[5];
+        if (!tokens || !isInteger(fields[4]) || !isInteger(fields[5]))
+        {
+            tokens.clear();
+            tokens.seekg(countersPos);
+            fields[4] = "0";
+            fields[5] = "1";
+        }
+        std::getline(tokens, rest);
+        if (fields[3].empty() || !parseResult(rest, &result))
+        {
+            fprintf(stderr, "%s:%d: no position or result, skipping\n",
+                    fileName.c_str(), lineNum);
+            continue;
+        }
+        for (int i = 0; i < 6; i++)
+            fen += fields[i] + " ";
+        if (fenToBoard(fen.c_str(), &board) < 0)
+        {
+            fprintf(stderr, "%s:%d: bad position, skipping\n",
+                    fileName.c_str(), lineNum);
+            continue;
+        }
+        data.positions.push_back(board.Position());
+        data.results.push_back(result);
+        numLoaded++;
+    }
+    return numLoaded;
+}
+
+// Returns: true iff 'fileName' was read.  Unknown names are ignored (with a
+//  warning).
+static bool loadParams(const std::string &fileName)
+{
+    std::vector<EvalParamT> params = EvalParamsList();
+    std::ifstream file(fileName);
+    std::string name;
+    int value;
+
+    if (!file)
+        return false;
+    while (file >> name >> value)
+    {
+        bool found = false;
+        for (EvalParamT &param : params)
+        {
+            if (param.name == name)
+            {
+                *param.value = value;
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            fprintf(stderr, "%s: unknown weight '%s', ignoring\n",
+                    fileName.c_str(), name.c_str());
+    }
+    EvalParamsChanged();
+    return true;
+}
+
+// Writes all the weights to 'fileName' (via a temporary file, so an
+//  interrupted run does not leave a truncated file behind).
+static void saveParams(const std::string &fileName)
+{
+    std::string tmpName = fileName + ".tmp";
+    FILE *file = fopen(tmpName.c_str(), "w");
+
+    if (file == nullptr)
+    {
+        fprintf(stderr, "could not write '%s'\n", tmpName.c_str());
+        return;
+    }
+    for (const EvalParamT &param : EvalParamsList())
+        fprintf(file, "%s %d\n", param.name.c_str(), *param.value);
+    if (fclose(file) != 0 || rename(tmpName.c_str(), fileName.c_str()) != 0)
+        fprintf(stderr, "could not write '%s'\n", fileName.c_str());
+}
+
+// Quiesces every position in 'data' (using all of 'thinkers'), and fills in
+//  'data.scores'.
+static void quiesceAll(const std::vector<Thinker *> &thinkers,
+                       TuneDataT &data)
+{
+    std::atomic<size_t> next(0);
+    size_t numPositions = data.positions.size();
+    Semaphore doneSem;
+
+    for (Thinker *th : thinkers)
+    {
+        // Run on the thinker's own thread, like any other search.
+        th->PostCmd([th, &data, &next, numPositions, &doneSem]()
+        {
+            Board &board = th->Context().board;
+
+            // The pawn weights may have changed since our last pass.
+            PawnClearCache();
+            size_t start;
+            while ((start = next.fetch_add(kBlockSize)) < numPositions)
+            {
+                size_t end = MIN(start + kBlockSize, numPositions);
+                for (size_t i = start; i < end; i++)
+                {
+                    const Position &position = data.positions[i];
+                    board.SetPosition(position);
+                    int score = quiesce(th, Eval::Loss, Eval::Win).LowBound();
+                    data.scores[i] = position.Turn() == 0 ? score : -score;
+                }
+            }
+            doneSem.post();
+        });
+    }
+    for (size_t i = 0; i < thinkers.size(); i++)
+        doneSem.wait();
+}
+
+// Returns: the mean squared difference between the actual results, and the
+//  results predicted by 'data.scores' (scaled by 'k').
+static double loss(const TuneDataT &data, double k)
+{
+    double sum = 0.0;
+
+    for (size_t i = 0; i < data.scores.size(); i++)
+    {
+        double expected = 1.0 / (1.0 + pow(10.0, -k * data.scores[i] / 400.0));
+        double error = data.results[i] - expected;
+        sum += error * error;
+    }
+    return sum / data.scores.size();
+}
+
+// Returns: the 'k' that best fits the current 'data.scores'.
+static double fitK(const TuneDataT &data)
+{
+    double bestK = 1.0, bestLoss = loss(data, bestK);
+
+    // Coarse, then fine.
+    for (double step = 0.1; step >= 0.001; step /= 10)
+    {
+        double center = bestK;
+        for (int i = -10; i <= 10; i++)
+        {
+            double k = center + i * step;
+            double myLoss;
+            if (k > 0.0 && (myLoss = loss(data, k)) < bestLoss)
+            {
+                bestK = k;
+                bestLoss = myLoss;
+            }
+        }
+    }
+    return bestK;
+}
+
+static void tune(const std::vector<Thinker *> &thinkers, TuneDataT &data,
+                 const TuneOptionsT &options)
+{
+    std::vector<EvalParamT> params;
+    bigtime_t startTime = CurrentTime();
+
+    for (const EvalParamT &param : EvalParamsList())
+    {
+        if (param.name.compare(0, options.only.size(), options.only) == 0)
+            params.push_back(param);
+    }
+
+    quiesceAll(thinkers, data);
+    bigtime_t elapsed = MAX(CurrentTime() - startTime, 1);
+    printf("quiesced %zu positions in %.3f seconds (%.0f positions/sec)\n",
+           data.positions.size(), elapsed / 1000000.0,
+           data.positions.size() * 1000000.0 / elapsed);
+
+    double k = options.k >= 0.0 ? options.k : fitK(data);
+    double bestLoss = loss(data, k);
+    printf("K %.3f, initial loss %.8f, tuning %zu weights\n",
+           k, bestLoss, params.size());
+
+    for (int iteration = 1; iteration <= options.maxIterations; iteration++)
+    {
+        int numImproved = 0;
+
+        for (EvalParamT &param : params)
+        {
+            int origValue = *param.value;
+            bool improved = false;
+
+            for (int delta : {options.step, -options.step})
+            {
+                *param.value = origValue + delta;
+                EvalParamsChanged();
+                quiesceAll(thinkers, data);
+                double myLoss = loss(data, k);
+                if (myLoss < bestLoss)
+                {
+                    bestLoss = myLoss;
+                    improved = true;
+                    break;
+                }
+            }
+            if (improved)
+            {
+                numImproved++;
+                continue;
+            }
+            *param.value = origValue;
+            EvalParamsChanged();
+        }
+
+        printf("iteration %d: loss %.8f, %d weights changed, %.0f seconds\n",
+               iteration, bestLoss, numImproved,
+               (CurrentTime() - startTime) / 1000000.0);
+        fflush(stdout);
+        saveParams(options.outFile);
+        if (numImproved == 0)
+            break; // We found a local minimum.
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    TuneOptionsT options = {SystemTotalProcessors(), 100, 1, -1.0, "", "",
+                            "arctic-tune.params"};
+    std::vector<std::string> fileNames;
+    char buf[256];
+
+    arctic::Timer::InitSubsystem();
+    LogInit();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strncmp(argv[i], "-p=", 3))
+        {
+            if (sscanf(argv[i], "-p=%d", &options.numThreads) != 1 ||
+                options.numThreads < 1)
+            {
+                usage(argv[0]);
+            }
+        }
+        else if (!strncmp(argv[i], "-i=", 3))
+        {
+            if (sscanf(argv[i], "-i=%d", &options.maxIterations) != 1)
+                usage(argv[0]);
+        }
+        else if (!strncmp(argv[i], "-s=", 3))
+        {
+            if (sscanf(argv[i], "-s=%d", &options.step) != 1 ||
+                options.step < 1)
+            {
+                usage(argv[0]);
+            }
+        }
+        else if (!strncmp(argv[i], "-k=", 3))
+        {
+            if (sscanf(argv[i], "-k=%lf", &options.k) != 1 ||
+                options.k <= 0.0)
+            {
+                usage(argv[0]);
+            }
+        }
+        else if (sscanf(argv[i], "--only=%255s", buf) == 1)
+            options.only = buf;
+        else if (sscanf(argv[i], "--params=%255s", buf) == 1)
+            options.paramsFile = buf;
+        else if (sscanf(argv[i], "-o=%255s", buf) == 1)
+            options.outFile = buf;
+        else if (argv[i][0] == '-')
+            usage(argv[0]);
+        else
+            fileNames.push_back(argv[i]);
+    }
+    if (fileNames.empty())
+        usage(argv[0]);
+
+    // Must be done before any Boards are declared.
+    gPreCalcInit(-1, options.numThreads);
+    static UIFuncTableT tuneUIFuncTable = {};
+    tuneUIFuncTable.notifyError = tuneNotifyError;
+    gUI = &tuneUIFuncTable;
+
+    if (!options.paramsFile.empty() && !loadParams(options.paramsFile))
+    {
+        fprintf(stderr, "could not read '%s'\n", options.paramsFile.c_str());
+        return 1;
+    }
+
+    TuneDataT data;
+    for (const std::string &fileName : fileNames)
+    {
+        int numLoaded = loadFile(fileName, data);
+        if (numLoaded < 0)
+        {
+            fprintf(stderr, "could not read '%s'\n", fileName.c_str());
+            return 1;
+        }
+        printf("%s: %d positions\n", fileName.c_str(), numLoaded);
+    }
+    if (data.positions.empty())
+        return 1;
+    data.scores.resize(data.positions.size());
+
+    // One thinker per thread.  (Thinkers cannot be destroyed, so we just let
+    //  them go at exit.)
+    EventQueue rspQueue; // (nothing we do sends responses)
+    std::vector<Thinker *> thinkers;
+    for (int i = 0; i < options.numThreads; i++)
+        thinkers.push_back(new Thinker(rspQueue, Thinker::RspHandlerT()));
+
+    // Everything we quiesce must reflect the current weights, so disable
+    //  anything that might remember an old eval.
+    Thinker::SharedContextT &sharedContext = thinkers[0]->SharedContext();
+    sharedContext.transTable.Reset(0);
+    sharedContext.evalCache.Reset(0);
+    sharedContext.lazyEvalMargin = 0;
+
+    tune(thinkers, data, options);
+    saveParams(options.outFile);
+    printf("wrote %s\n", options.outFile.c_str());
+    return 0;
+}
@@ -953,9 +953,9 @@ static void UINotifyComputerStats(const EngineStatsT *stats)
 {
     gotoxy(1, 1);
     textcolor(SYSTEMCOL);
-    cprintf("%d %d %d %d ",
+    cprintf("%d %d %d %d %d %d ",
             stats->nodes, stats->nonQNodes, stats->moveGenNodes,
-            stats->hashHitGood);
+            stats->hashHitGood, stats->evalCacheHits, stats->lazyEvals);
 }
 
 static void UINotifyDraw(const char *reason, MoveT *move)
@@ -70,6 +70,7 @@
 #include "gPreCalc.h"
 #include "log.h"
 #include "MoveList.h"
+#include "Nnue.h"
 #include "stringUtil.h"
 #include "ui.h"
 #include "uiUtil.h"
@@ -232,8 +233,8 @@ static void uciInit(Game *game, Switcher *sw)
     //  interfaces.
     game->EngineConfig().SetCheckbox(Config::CanResignCheckbox, false);
     game->SetAutoPlayEngineMoves(false);
-    // FIXME we don't want to do this until later (because initializing the
-    //  transposition table can take some time), but for now it's okay.
+    // (The transposition table is allocated and cleared in the background,
+    //  so this does not hold up the GUI.)
     uiPrepareEngines(game);
     initialized = true;
 }
@@ -242,6 +243,9 @@ void processUciCommand(Game *game, Switcher *sw)
 {
     char hashString[100] = "";
     char threadsString[100] = "";
+    char evalCacheString[100] = "";
+    char lazyEvalString[100] = "";
+    char hashMinDepthString[100] = "";
     int rv;
 
     uciInit(game, sw);
@@ -264,21 +268,56 @@ void processUciCommand(Game *game, Switcher *sw)
         // bail on truncated string.
         assert(rv >= 0 && (uint) rv < sizeof(threadsString));
     }
+    sItem = game->EngineConfig().SpinItemAt(Config::EvalCacheSpin);
+    if (sItem != nullptr)
+    {
+        rv = snprintf(evalCacheString, sizeof(evalCacheString),
+                      "option name EvalCache type spin default %d min 0 max "
+                      "%d\n",
+                      sItem->Value(), sItem->Max());
+        // bail on truncated string.
+        assert(rv >= 0 && (uint) rv < sizeof(evalCacheString));
+    }
+    sItem = game->EngineConfig().SpinItemAt(Config::LazyEvalMarginSpin);
+    if (sItem != nullptr)
+    {
+        rv = snprintf(lazyEvalString, sizeof(lazyEvalString),
+                      "option name LazyEvalMargin type spin default %d min 0 "
+                      "max %d\n",
+                      sItem->Value(), sItem->Max());
+        // bail on truncated string.
+        assert(rv >= 0 && (uint) rv < sizeof(lazyEvalString));
+    }
+    sItem = game->EngineConfig().SpinItemAt(Config::HashMinDepthSpin);
+    if (sItem != nullptr)
+    {
+        rv = snprintf(hashMinDepthString, sizeof(hashMinDepthString),
+                      "option name HashMinDepth type spin default %d min %d "
+                      "max %d\n",
+                      sItem->Value(), sItem->Min(), sItem->Max());
+        // bail on truncated string.
+        assert(rv >= 0 && (uint) rv < sizeof(hashMinDepthString));
+    }
     
     // Respond appropriately to the "uci" command.
     printf("id name arctic %s.%s-%s\n"
            "id author Lucian Landry\n"
-           "%s%s"
+           "%s%s%s%s%s"
            // Though we do not care what "Ponder" is set to, we must
            // provide it as an option to signal (according to UCI) that the
            // engine can ponder at all.
            "option name Ponder type check default true\n"
            "option name RandomMoves type check default true\n"
+           "option name EvalFile type string default <empty>\n"
+           "option name HashFile type string default <empty>\n"
+           "option name SaveHash type button\n"
+           "option name LoadHash type button\n"
            "option name UCI_EngineAbout type string default arctic %s.%s-%s by"
            " Lucian Landry\n"
            "uciok\n",
            VERSION_STRING_MAJOR, VERSION_STRING_MINOR, VERSION_STRING_PHASE,
-           hashString, threadsString,
+           hashString, threadsString, evalCacheString, lazyEvalString,
+           hashMinDepthString,
            VERSION_STRING_MAJOR, VERSION_STRING_MINOR, VERSION_STRING_PHASE);
 
     // switch to uiUci if we have not already.
@@ -410,6 +449,9 @@ static void processSetOptionCommand(Game *game, const char *inputStr)
 {
     int64 hashSizeMiB;
     int numThreads;
+    int evalCacheMiB;
+    int lazyEvalMargin;
+    int hashMinDepth;
     const char *pToken;
 
     if (isSearching())
@@ -452,6 +494,66 @@ static void processSetOptionCommand(Game *game, const char *inputStr)
     {
         game->EngineConfig().SetSpinClamped(Config::MaxThreadsSpin, numThreads);
     }
+    else if (matchesNoCase(pToken, "EvalCache") &&
+             matches((pToken = findNextToken(pToken)), "value") &&
+             convertNextInteger(&pToken, &evalCacheMiB, 0, "EvalCache") == 0)
+    {
+        game->EngineConfig().SetSpinClamped(Config::EvalCacheSpin,
+                                            evalCacheMiB);
+    }
+    else if (matchesNoCase(pToken, "LazyEvalMargin") &&
+             matches((pToken = findNextToken(pToken)), "value") &&
+             convertNextInteger(&pToken, &lazyEvalMargin, 0,
+                                "LazyEvalMargin") == 0)
+    {
+        game->EngineConfig().SetSpinClamped(Config::LazyEvalMarginSpin,
+                                            lazyEvalMargin);
+    }
+    else if (matchesNoCase(pToken, "HashMinDepth") &&
+             matches((pToken = findNextToken(pToken)), "value") &&
+             convertNextInteger(&pToken, &hashMinDepth, -1,
+                                "HashMinDepth") == 0)
+    {
+        game->EngineConfig().SetSpinClamped(Config::HashMinDepthSpin,
+                                            hashMinDepth);
+    }
+    else if (matchesNoCase(pToken, "EvalFile") &&
+             matches((pToken = findNextToken(pToken)), "value"))
+    {
+        // The value is the rest of the line (since paths may contain spaces).
+        pToken = findNextToken(pToken);
+        std::string fileName(pToken != NULL ? pToken : "");
+        while (!fileName.empty() && isspace(fileName.back()))
+            fileName.pop_back();
+        if (fileName == "<empty>")
+            fileName.clear();
+        game->EngineConfig().SetString(Config::EvalFileString, fileName);
+        if (!fileName.empty() && NnueNetId() == 0)
+        {
+            reportError(false, "%s: could not load EvalFile '%s', using "
+                        "built-in evaluation", __func__, fileName.c_str());
+        }
+    }
+    else if (matchesNoCase(pToken, "HashFile") &&
+             matches((pToken = findNextToken(pToken)), "value"))
+    {
+        // (Like EvalFile, the value is the rest of the line.)
+        pToken = findNextToken(pToken);
+        std::string fileName(pToken != NULL ? pToken : "");
+        while (!fileName.empty() && isspace(fileName.back()))
+            fileName.pop_back();
+        if (fileName == "<empty>")
+            fileName.clear();
+        game->EngineConfig().SetString(Config::HashFileString, fileName);
+    }
+    else if (matchesNoCase(pToken, "SaveHash"))
+    {
+        game->EngineConfig().SetButton(Config::SaveHashButton);
+    }
+    else if (matchesNoCase(pToken, "LoadHash"))
+    {
+        game->EngineConfig().SetButton(Config::LoadHashButton);
+    }
     else if (matchesNoCase(pToken, "Ponder") &&
              matches((pToken = findNextToken(pToken)), "value") &&
              (matchesNoCase((pToken = findNextToken(pToken)), "true") ||
@@ -771,6 +873,10 @@ static void uciPlayerMove()
         // Force debugging on if we get a bad arg, under the theory that we
         // would like to debug the problem :P
         gUciState.bDebug = !matches(findNextToken(inputStr), "off");
+        // Debug mode also gets us (slow) hash collision checking, and
+        //  hash diagnostics after each search.
+        game->EngineConfig().SetCheckbox(Config::HashDiagnosticsCheckbox,
+                                         gUciState.bDebug);
     }
     else if (matches(inputStr, "isready"))
     {
@@ -960,11 +1066,64 @@ static void uciNotifyPV(const EnginePvArgsT *pvArgs)
 }
 
 
+// Prints what we know about how the transposition table is doing (meant to
+//  help size it).
+static void uciNotifyHashStats(const HashStatsT &hash)
+{
+    static const char *const writeNames[int(HashStatsT::Write::NumWrites)] =
+        {"empty", "same", "stale", "shallower", "skipped"};
+
+    printf("info string hash sampled %d used", hash.sampled);
+    for (int i = 0; i < HashStatsT::kNumAges; i++)
+    {
+        printf(" age%d%s %d", i, i == HashStatsT::kNumAges - 1 ? "+" : "",
+               hash.ages[i]);
+    }
+    printf("\n");
+
+    for (int i = 0; i < HashStatsT::kNumDepths; i++)
+    {
+        if (!hash.probes[i])
+            continue;
+        char depthString[8];
+        if (i == 0)
+            snprintf(depthString, sizeof(depthString), "q");
+        else
+            snprintf(depthString, sizeof(depthString), "%d%s", i - 1,
+                     i == HashStatsT::kNumDepths - 1 ? "+" : "");
+        printf("info string hash depth %s probes %d hits %d cutoffs %d\n",
+               depthString, hash.probes[i], hash.hits[i], hash.cutoffs[i]);
+    }
+
+    printf("info string hash writes");
+    for (int i = 0; i < int(HashStatsT::Write::NumWrites); i++)
+        printf(" %s %d", writeNames[i], hash.writes[i]);
+    printf("\n");
+
+    printf("info string hash collisions %d pathdependent %d\n",
+           hash.collisions, hash.pathDependent);
+}
+
 static void uciNotifyComputerStats(const EngineStatsT *stats)
 {
     char statsString[80];
 
     printf("info %s\n", buildStatsString(statsString, gUciState.game, stats));
+    if (stats->evalCacheProbes)
+    {
+        printf("info string evalcache hits %d permille\n",
+               int(uint64(stats->evalCacheHits) * 1000 /
+                   stats->evalCacheProbes));
+    }
+    if (stats->lazyEvals + stats->fullEvals)
+    {
+        printf("info string lazyeval %d full %d\n",
+               stats->lazyEvals, stats->fullEvals);
+    }
+    if (stats->hashPageKiB)
+        printf("info string hash pages %d kB\n", stats->hashPageKiB);
+    if (gUciState.bDebug)
+        uciNotifyHashStats(stats->hash);
 }
 
 static void uciPositionRefresh(const Position &position) { }